@@ -0,0 +1,179 @@
+/**
+ * @file AABB.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Axis-aligned bounding boxes, the building block of the acceleration structures.
+ * @sa BVH.hpp
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/vec3.hpp>
+
+#include "Ray.hpp"
+#include "RayPacket.hpp"
+
+/**
+ * @brief An axis-aligned box defined by its two extreme corners.
+ * @class AABB
+ */
+struct AABB {
+    /**
+     * @brief The corner with the smallest coordinates.
+     *
+     */
+    glm::vec3 min;
+
+    /**
+     * @brief The corner with the largest coordinates.
+     *
+     */
+    glm::vec3 max;
+
+    /**
+     * @brief Grow the box so that it contains a point.
+     *
+     * @param pt the point to include
+     */
+    void expand(const glm::vec3 &pt) {
+        min = glm::vec3(std::min(min.x, pt.x), std::min(min.y, pt.y), std::min(min.z, pt.z));
+        max = glm::vec3(std::max(max.x, pt.x), std::max(max.y, pt.y), std::max(max.z, pt.z));
+    }
+
+    /**
+     * @brief Grow the box so that it contains another box.
+     *
+     * @param box the box to include
+     */
+    void expand(const AABB &box) {
+        expand(box.min);
+        expand(box.max);
+    }
+
+    /**
+     * @brief Get the center of the box
+     *
+     * @return glm::vec3
+     */
+    glm::vec3 centroid() const { return (min + max) * 0.5f; }
+
+    /**
+     * @brief Get the extent of the box along each axis
+     *
+     * @return glm::vec3
+     */
+    glm::vec3 extent() const { return max - min; }
+
+    /**
+     * @brief The surface area of the box, used by the surface area heuristic. An empty box has
+     * no area.
+     *
+     * @return float
+     */
+    float surfaceArea() const {
+        if (isEmpty()) return 0;
+        glm::vec3 e = extent();
+        return 2 * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    /**
+     * @brief Returns true if the box does not contain any point.
+     *
+     */
+    bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    /**
+     * @brief Slab test between the box and a ray: the interval [t0, t1] of distances along the
+     * ray is clipped by the two planes of each axis. The planes are picked with the precomputed
+     * sign of the direction rather than compared, so that the test has no branch, and for a ray
+     * parallel to a face and starting on it, 0 * inf = NaN only replaces a bound that would not
+     * constrain the interval, and is ignored by the comparisons.
+     *
+     * @param iRay the incoming ray
+     * @param t0 the start of the interval, raised to the distance at which the ray enters the box
+     * @param t1 the end of the interval, lowered to the distance at which the ray leaves the box
+     */
+    void clip(const Ray &iRay, float &t0, float &t1) const {
+        const glm::vec3 origin = iRay.getInitPt();
+        const glm::vec3 invDir = iRay.getInvDir();
+        for (int axis = 0; axis < 3; ++axis) {
+            const int negative = iRay.getSign(axis);
+            float tA = ((negative ? max : min)[axis] - origin[axis]) * invDir[axis];
+            float tB = ((negative ? min : max)[axis] - origin[axis]) * invDir[axis];
+            t0 = tA > t0 ? tA : t0;
+            t1 = tB < t1 ? tB : t1;
+        }
+    }
+
+    /**
+     * @brief Tells whether a ray goes through the box between its origin and tMax, with the slab
+     * test of clip. This is the test of the nodes of the BVH.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections further than tMax are ignored
+     * @param tNear the distance at which the ray enters the box, modified when there is a hit
+     * @return true if the ray goes through the box before tMax
+     */
+    bool intersect(const Ray &iRay, const float &tMax, float &tNear) const {
+        float t0 = 0;
+        float t1 = tMax;
+        clip(iRay, t0, t1);
+        tNear = t0;
+        // Conservative comparison so that rounding errors never cull a primitive lying on a face
+        return t0 <= t1 * 1.0000008f;
+    }
+
+    /**
+     * @brief The same slab test as intersect for all the rays of a packet at once.
+     *
+     * @param packet the incoming rays
+     * @param tMax the intersections further than tMax[lane] are ignored for the ray lane
+     * @param tNear the closest distance at which one of the rays enters the box, modified when
+     * there is a hit
+     * @return true if at least one of the rays goes through the box before its tMax
+     */
+    bool intersect(const RayPacket &packet, const float *tMax, float &tNear) const {
+        float closest = INFINITY;
+#pragma omp simd reduction(min : closest)
+        for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+            float t0 = 0;
+            float t1 = tMax[lane];
+            const float origins[3] = {packet.ox[lane], packet.oy[lane], packet.oz[lane]};
+            const float invDirs[3] = {packet.invDx[lane], packet.invDy[lane], packet.invDz[lane]};
+            for (int axis = 0; axis < 3; ++axis) {
+                float tLow = (min[axis] - origins[axis]) * invDirs[axis];
+                float tHigh = (max[axis] - origins[axis]) * invDirs[axis];
+                bool negative = invDirs[axis] < 0;
+                float tA = negative ? tHigh : tLow;
+                float tB = negative ? tLow : tHigh;
+                t0 = tA > t0 ? tA : t0;
+                t1 = tB < t1 ? tB : t1;
+            }
+            float lane0 = t0 <= t1 * 1.0000008f ? t0 : INFINITY;
+            closest = lane0 < closest ? lane0 : closest;
+        }
+        tNear = closest;
+        return closest != INFINITY;
+    }
+
+    /**
+     * @brief Construct an empty box, which can be grown with expand.
+     *
+     */
+    AABB()
+        : min(glm::vec3(INFINITY, INFINITY, INFINITY)),
+          max(glm::vec3(-INFINITY, -INFINITY, -INFINITY)) {}
+
+    /**
+     * @brief Construct a box from its two corners.
+     *
+     * @param min the corner with the smallest coordinates
+     * @param max the corner with the largest coordinates
+     */
+    AABB(const glm::vec3 &min, const glm::vec3 &max) : min(min), max(max) {}
+};
@@ -0,0 +1,150 @@
+/**
+ * @file BVH.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Construction of the bounding volume hierarchy with a binned surface area heuristic.
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "BVH.hpp"
+
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief The number of candidate split planes tested along each axis.
+ *
+ */
+constexpr int SAH_BINS = 16;
+
+/**
+ * @brief The cost of traversing a node relatively to the cost of intersecting a primitive.
+ *
+ */
+constexpr float TRAVERSAL_COST = 1.0f;
+
+}  // namespace
+
+void BVH::build(const std::vector<AABB> &primBounds) {
+    nodes.clear();
+    primIds.clear();
+    if (primBounds.empty()) return;
+
+    std::vector<glm::vec3> centroids;
+    centroids.reserve(primBounds.size());
+    primIds.reserve(primBounds.size());
+    for (unsigned id = 0; id < primBounds.size(); ++id) {
+        centroids.push_back(primBounds[id].centroid());
+        primIds.push_back(id);
+    }
+
+    // A binary tree with n leaves has 2n - 1 nodes
+    nodes.reserve(2 * primBounds.size());
+    Node root;
+    root.first = 0;
+    root.count = primBounds.size();
+    nodes.push_back(root);
+    split(0, primBounds, centroids, 0);
+    nodes.shrink_to_fit();
+}
+
+void BVH::split(unsigned nodeId, const std::vector<AABB> &primBounds,
+                const std::vector<glm::vec3> &centroids, unsigned depth) {
+    const unsigned first = nodes[nodeId].first;
+    const unsigned count = nodes[nodeId].count;
+
+    AABB bounds;
+    AABB centroidBounds;
+    for (unsigned id = first; id < first + count; ++id) {
+        bounds.expand(primBounds[primIds[id]]);
+        centroidBounds.expand(centroids[primIds[id]]);
+    }
+    nodes[nodeId].bounds = bounds;
+
+    if (count <= maxLeafSize || depth >= MAX_DEPTH) return;
+
+    // Look for the cheapest split plane among the bins of every axis
+    int bestAxis = -1;
+    int bestBin = 0;
+    float bestCost = count;  // cost of keeping the node as a leaf
+    glm::vec3 cExtent = centroidBounds.extent();
+    for (int axis = 0; axis < 3; ++axis) {
+        if (cExtent[axis] <= 0) continue;
+
+        AABB binBounds[SAH_BINS];
+        unsigned binCount[SAH_BINS] = {0};
+        float scale = SAH_BINS / cExtent[axis];
+        for (unsigned id = first; id < first + count; ++id) {
+            unsigned primId = primIds[id];
+            int bin = std::min(SAH_BINS - 1,
+                               (int)((centroids[primId][axis] - centroidBounds.min[axis]) * scale));
+            binBounds[bin].expand(primBounds[primId]);
+            ++binCount[bin];
+        }
+
+        // Sweep from the right to get the area and count on the right of each plane
+        float rightArea[SAH_BINS];
+        unsigned rightCount[SAH_BINS];
+        AABB rightBox;
+        unsigned rightSum = 0;
+        for (int bin = SAH_BINS - 1; bin > 0; --bin) {
+            rightBox.expand(binBounds[bin]);
+            rightSum += binCount[bin];
+            rightArea[bin] = rightBox.surfaceArea();
+            rightCount[bin] = rightSum;
+        }
+
+        // Then from the left, the plane number "bin" separating bins [0, bin[ and [bin, end[
+        AABB leftBox;
+        unsigned leftSum = 0;
+        for (int bin = 1; bin < SAH_BINS; ++bin) {
+            leftBox.expand(binBounds[bin - 1]);
+            leftSum += binCount[bin - 1];
+            if (!leftSum || !rightCount[bin]) continue;
+            float cost = TRAVERSAL_COST + (leftBox.surfaceArea() * leftSum +
+                                           rightArea[bin] * rightCount[bin]) /
+                                              bounds.surfaceArea();
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = bin;
+            }
+        }
+    }
+
+    // No split is cheaper than the leaf (or all the centroids are at the same place)
+    if (bestAxis == -1) return;
+
+    float scale = SAH_BINS / cExtent[bestAxis];
+    auto middle = std::partition(
+        primIds.begin() + first, primIds.begin() + first + count, [&](unsigned primId) {
+            int bin = std::min(
+                SAH_BINS - 1,
+                (int)((centroids[primId][bestAxis] - centroidBounds.min[bestAxis]) * scale));
+            return bin < bestBin;
+        });
+    unsigned leftCount = middle - (primIds.begin() + first);
+
+    Node left;
+    left.first = first;
+    left.count = leftCount;
+    Node right;
+    right.first = first + leftCount;
+    right.count = count - leftCount;
+
+    unsigned leftId = nodes.size();
+    nodes.push_back(left);
+    nodes.push_back(right);
+    nodes[nodeId].first = leftId;
+    nodes[nodeId].count = 0;
+
+    split(leftId, primBounds, centroids, depth + 1);
+    split(leftId + 1, primBounds, centroids, depth + 1);
+}
+
+void BVH::renumberPrimitives(std::vector<unsigned> &order) {
+    order = primIds;
+    for (unsigned id = 0; id < primIds.size(); ++id) primIds[id] = id;
+}
@@ -0,0 +1,382 @@
+/**
+ * @file BVH.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A bounding volume hierarchy, built with the surface area heuristic (SAH), to avoid
+ * testing every primitive of a group against every ray.
+ * @sa AABB.hpp
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "AABB.hpp"
+#include "Ray.hpp"
+
+/**
+ * @class BVH
+ * @brief A binary tree of bounding boxes over a set of primitives, identified by their index.
+ * The primitives themselves are not stored: the owner of the BVH gives their bounds at build time
+ * and intersects them in the callback given to traverse.
+ *
+ */
+class BVH {
+public:
+    /**
+     * @brief The maximum depth of the tree, which bounds the size of the traversal stack.
+     *
+     */
+    static constexpr unsigned MAX_DEPTH = 64;
+
+    /**
+     * @brief A node of the tree. Leaves have a positive count and point to a range of primIds,
+     * inner nodes have a count of 0 and their children are stored at first and first + 1.
+     *
+     */
+    struct Node {
+        AABB bounds;
+        unsigned first;
+        unsigned count;
+
+        bool isLeaf() const { return count > 0; }
+    };
+
+protected:
+    /**
+     * @brief The nodes of the tree, the root being the first one.
+     *
+     */
+    std::vector<Node> nodes;
+
+    /**
+     * @brief The indices of the primitives, ordered so that each leaf owns a contiguous range.
+     *
+     */
+    std::vector<unsigned> primIds;
+
+    /**
+     * @brief The maximum number of primitives in a leaf.
+     *
+     */
+    unsigned maxLeafSize;
+
+    /**
+     * @brief Recursively split a node using the binned surface area heuristic.
+     *
+     * @param nodeId the index of the node to split
+     * @param primBounds the bounds of all the primitives
+     * @param centroids the centers of the bounds of all the primitives
+     * @param depth the depth of the node in the tree
+     */
+    void split(unsigned nodeId, const std::vector<AABB> &primBounds,
+               const std::vector<glm::vec3> &centroids, unsigned depth);
+
+public:
+    /**
+     * @brief Build the tree over the primitives. The primitive i is the one of bounds
+     * primBounds[i].
+     *
+     * @param primBounds the bounds of the primitives
+     */
+    void build(const std::vector<AABB> &primBounds);
+
+    /**
+     * @brief Let the owner store its primitives in the order of the leaves, so that each leaf
+     * covers a contiguous range of them. Once the owner has moved its primitive order[i] to the
+     * position i, the ids given to the callbacks are these positions.
+     *
+     * @param order the former id of the primitive to store at each position
+     */
+    void renumberPrimitives(std::vector<unsigned> &order);
+
+    /**
+     * @brief Replace the tree by a tree built before, for instance read from a file
+     *
+     * @param treeNodes the nodes, the root first
+     * @param treePrimIds the primitives of the leaves
+     */
+    void setNodes(std::vector<Node> treeNodes, std::vector<unsigned> treePrimIds) {
+        nodes = std::move(treeNodes);
+        primIds = std::move(treePrimIds);
+    }
+
+    /**
+     * @brief Returns true if the tree has not been built or contains no primitive.
+     *
+     */
+    bool empty() const { return nodes.empty(); }
+
+    /**
+     * @brief Get the bounds of all the primitives of the tree
+     *
+     * @return AABB
+     */
+    AABB getBounds() const { return nodes.empty() ? AABB() : nodes[0].bounds; }
+
+    /**
+     * @brief Get the nodes of the tree
+     *
+     * @return const std::vector<Node>&
+     */
+    const std::vector<Node> &getNodes() const { return nodes; }
+
+    /**
+     * @brief Get the indices of the primitives in the order of the leaves
+     *
+     * @return const std::vector<unsigned>&
+     */
+    const std::vector<unsigned> &getPrimIds() const { return primIds; }
+
+    /**
+     * @brief Walk through the nodes reached by a ray, the closest child first, and call
+     * primHit(primId, tMax) on the primitives of the leaves. primHit must lower tMax when the
+     * primitive is hit closer than tMax, so that the further nodes are skipped.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the closest distance found so far, lowered by primHit
+     * @param primHit the intersection callback
+     */
+    template <typename PrimHit>
+    void traverse(const Ray &iRay, float &tMax, PrimHit primHit) const;
+
+    /**
+     * @brief The same walk as traverse, calling leafHit(first, count, tMax) once per leaf with
+     * the range [first, first + count[ of getPrimIds() it covers, so that the owner can test the
+     * primitives of a leaf together.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the closest distance found so far, lowered by leafHit
+     * @param leafHit the intersection callback
+     */
+    template <typename LeafHit>
+    void traverseLeaves(const Ray &iRay, float &tMax, LeafHit leafHit) const;
+
+    /**
+     * @brief Walk through the nodes reached by a ray before tMax and call primTest(primId) on the
+     * primitives of the leaves, until one of the calls returns true. Used for the occlusion
+     * queries, where any hit is enough and the order of the nodes does not matter.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the nodes further than tMax are skipped
+     * @param primTest the occlusion callback
+     * @return true if primTest returned true for a primitive
+     */
+    template <typename PrimTest>
+    bool traverseAny(const Ray &iRay, float tMax, PrimTest primTest) const;
+
+    /**
+     * @brief The same walk as traverse for a packet of rays: a node is visited if any ray of the
+     * packet reaches it before its tMax, and primHit(primId) is then called for the whole packet.
+     * primHit must lower tMax for the rays which hit the primitive.
+     *
+     * @param packet the incoming rays
+     * @param tMax the closest distance found so far for each ray, lowered by primHit
+     * @param primHit the intersection callback
+     */
+    template <typename PrimHit>
+    void traversePacket(const RayPacket &packet, const float *tMax, PrimHit primHit) const;
+
+    /**
+     * @brief Occlusion query of several rays at once, typically the shadow rays of one hit point
+     * towards all the lights. A node is visited once if any of the rays still unblocked reaches
+     * it, and primTest(primId, rayId) is called for these rays only. The walk stops as soon as
+     * all the rays are blocked.
+     *
+     * @param rays the incoming rays
+     * @param tMax the nodes further than tMax[rayId] are skipped for the ray rayId
+     * @param blocked blocked[rayId] is set to true when primTest returns true for the ray rayId.
+     * The rays already blocked when calling are not tested.
+     * @param primTest the occlusion callback
+     */
+    template <typename PrimTest>
+    void traverseAnyBatch(const std::vector<Ray> &rays, const std::vector<float> &tMax,
+                          std::vector<char> &blocked, PrimTest primTest) const;
+
+    /**
+     * @brief Construct an empty BVH
+     *
+     * @param leafSize the maximum number of primitives in a leaf
+     */
+    explicit BVH(unsigned leafSize = 4) : maxLeafSize(leafSize) {}
+};
+
+template <typename PrimHit>
+void BVH::traverse(const Ray &iRay, float &tMax, PrimHit primHit) const {
+    traverseLeaves(iRay, tMax, [&](unsigned first, unsigned count, float &tClosest) {
+        for (unsigned id = first; id < first + count; ++id) primHit(primIds[id], tClosest);
+    });
+}
+
+template <typename LeafHit>
+void BVH::traverseLeaves(const Ray &iRay, float &tMax, LeafHit leafHit) const {
+    if (nodes.empty()) return;
+
+    float tNear;
+    if (!nodes[0].bounds.intersect(iRay, tMax, tNear)) return;
+
+    unsigned stack[MAX_DEPTH + 1];
+    float stackDist[MAX_DEPTH + 1];
+    int stackSize = 0;
+    stack[stackSize] = 0;
+    stackDist[stackSize++] = tNear;
+
+    while (stackSize) {
+        --stackSize;
+        // The node may have been reached before a closer hit was found
+        if (stackDist[stackSize] > tMax) continue;
+        const Node &node = nodes[stack[stackSize]];
+
+        if (node.isLeaf()) {
+            leafHit(node.first, node.count, tMax);
+            continue;
+        }
+
+        float tLeft, tRight;
+        bool hitLeft = nodes[node.first].bounds.intersect(iRay, tMax, tLeft);
+        bool hitRight = nodes[node.first + 1].bounds.intersect(iRay, tMax, tRight);
+
+        // Push the furthest child first so that the closest is popped first
+        if (hitLeft && hitRight) {
+            bool leftFirst = tLeft <= tRight;
+            stack[stackSize] = leftFirst ? node.first + 1 : node.first;
+            stackDist[stackSize++] = leftFirst ? tRight : tLeft;
+            stack[stackSize] = leftFirst ? node.first : node.first + 1;
+            stackDist[stackSize++] = leftFirst ? tLeft : tRight;
+        } else if (hitLeft) {
+            stack[stackSize] = node.first;
+            stackDist[stackSize++] = tLeft;
+        } else if (hitRight) {
+            stack[stackSize] = node.first + 1;
+            stackDist[stackSize++] = tRight;
+        }
+    }
+}
+
+template <typename PrimHit>
+void BVH::traversePacket(const RayPacket &packet, const float *tMax, PrimHit primHit) const {
+    if (nodes.empty()) return;
+
+    float tNear;
+    if (!nodes[0].bounds.intersect(packet, tMax, tNear)) return;
+
+    unsigned stack[MAX_DEPTH + 1];
+    float stackDist[MAX_DEPTH + 1];
+    int stackSize = 0;
+    stack[stackSize] = 0;
+    stackDist[stackSize++] = tNear;
+
+    while (stackSize) {
+        --stackSize;
+        // The node may have been reached before closer hits were found for all the rays
+        float furthest = -INFINITY;
+        for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+            furthest = tMax[lane] > furthest ? tMax[lane] : furthest;
+        }
+        if (stackDist[stackSize] > furthest) continue;
+        const Node &node = nodes[stack[stackSize]];
+
+        if (node.isLeaf()) {
+            for (unsigned id = node.first; id < node.first + node.count; ++id) {
+                primHit(primIds[id]);
+            }
+            continue;
+        }
+
+        float tLeft, tRight;
+        bool hitLeft = nodes[node.first].bounds.intersect(packet, tMax, tLeft);
+        bool hitRight = nodes[node.first + 1].bounds.intersect(packet, tMax, tRight);
+
+        // Push the furthest child first so that the closest is popped first
+        if (hitLeft && hitRight) {
+            bool leftFirst = tLeft <= tRight;
+            stack[stackSize] = leftFirst ? node.first + 1 : node.first;
+            stackDist[stackSize++] = leftFirst ? tRight : tLeft;
+            stack[stackSize] = leftFirst ? node.first : node.first + 1;
+            stackDist[stackSize++] = leftFirst ? tLeft : tRight;
+        } else if (hitLeft) {
+            stack[stackSize] = node.first;
+            stackDist[stackSize++] = tLeft;
+        } else if (hitRight) {
+            stack[stackSize] = node.first + 1;
+            stackDist[stackSize++] = tRight;
+        }
+    }
+}
+
+template <typename PrimTest>
+bool BVH::traverseAny(const Ray &iRay, float tMax, PrimTest primTest) const {
+    if (nodes.empty()) return false;
+
+    float tNear;
+    if (!nodes[0].bounds.intersect(iRay, tMax, tNear)) return false;
+
+    unsigned stack[MAX_DEPTH + 1];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize) {
+        const Node &node = nodes[stack[--stackSize]];
+
+        if (node.isLeaf()) {
+            for (unsigned id = node.first; id < node.first + node.count; ++id) {
+                if (primTest(primIds[id])) return true;
+            }
+            continue;
+        }
+
+        if (nodes[node.first + 1].bounds.intersect(iRay, tMax, tNear)) {
+            stack[stackSize++] = node.first + 1;
+        }
+        if (nodes[node.first].bounds.intersect(iRay, tMax, tNear)) {
+            stack[stackSize++] = node.first;
+        }
+    }
+    return false;
+}
+
+template <typename PrimTest>
+void BVH::traverseAnyBatch(const std::vector<Ray> &rays, const std::vector<float> &tMax,
+                           std::vector<char> &blocked, PrimTest primTest) const {
+    unsigned remaining = std::count(blocked.begin(), blocked.end(), 0);
+    if (nodes.empty() || !remaining) return;
+
+    // true if one of the unblocked rays goes through the node
+    auto reached = [&](const Node &node) {
+        float tNear;
+        for (unsigned rayId = 0; rayId < rays.size(); ++rayId) {
+            if (!blocked[rayId] && node.bounds.intersect(rays[rayId], tMax[rayId], tNear))
+                return true;
+        }
+        return false;
+    };
+
+    if (!reached(nodes[0])) return;
+
+    unsigned stack[MAX_DEPTH + 1];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize) {
+        const Node &node = nodes[stack[--stackSize]];
+
+        if (node.isLeaf()) {
+            for (unsigned id = node.first; id < node.first + node.count; ++id) {
+                for (unsigned rayId = 0; rayId < rays.size(); ++rayId) {
+                    if (!blocked[rayId] && primTest(primIds[id], rayId)) {
+                        blocked[rayId] = true;
+                        if (!--remaining) return;
+                    }
+                }
+            }
+            continue;
+        }
+
+        if (reached(nodes[node.first + 1])) stack[stackSize++] = node.first + 1;
+        if (reached(nodes[node.first])) stack[stackSize++] = node.first;
+    }
+}
@@ -0,0 +1,239 @@
+/**
+ * @file Framebuffer.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The image rendered by a ray tracer, before it is encoded
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+/**
+ * @brief A rectangle of pixels rendered by a single thread: the pixels (x, y) with x in
+ * [xBegin, xEnd[ and y in [yBegin, yEnd[.
+ *
+ */
+struct Tile {
+    unsigned xBegin;
+    unsigned xEnd;
+    unsigned yBegin;
+    unsigned yEnd;
+};
+
+/**
+ * @brief The pixels of an image as the sums of the colors of their samples, in floats: the colors
+ * are linear and are not clamped, 255 being the white. The x are the rows of the image and the y
+ * its columns.
+ *
+ * Allocated once, the threads writing the pixels of their own tiles. A framebuffer either holds the
+ * whole image, or streams it: it then only holds a window of rows, which are handed to a sink and
+ * reused once they are complete.
+ * @class Framebuffer
+ */
+class Framebuffer {
+public:
+    /**
+     * @brief The function receiving the complete rows of a streamed framebuffer, in order.
+     *
+     */
+    typedef std::function<void(const Framebuffer &framebuffer, unsigned x)> RowSink;
+
+protected:
+    unsigned resX;
+    unsigned resY;
+
+    /**
+     * @brief The number of rows held, the row x being stored in the slot x % windowRows.
+     *
+     */
+    unsigned windowRows;
+
+    /**
+     * @brief For each pixel, the sum of the colors of its samples and their number in w.
+     *
+     */
+    std::vector<glm::vec4> samples;
+
+    RowSink sink;
+
+public:
+    /**
+     * @brief Get the number of rows
+     *
+     * @return unsigned
+     */
+    unsigned getResX() const { return this->resX; }
+
+    /**
+     * @brief Get the number of columns
+     *
+     * @return unsigned
+     */
+    unsigned getResY() const { return this->resY; }
+
+    /**
+     * @brief The index of a pixel in the framebuffer
+     *
+     * @param x the row
+     * @param y the column
+     * @return unsigned
+     */
+    unsigned index(unsigned x, unsigned y) const { return (x % windowRows) * resY + y; }
+
+    /**
+     * @brief Tells whether the rows are handed to a sink instead of being kept
+     *
+     * @return true if the framebuffer only holds a window of rows
+     */
+    bool isStreamed() const { return (bool)sink; }
+
+    /**
+     * @brief Get the number of rows held
+     *
+     * @return unsigned
+     */
+    unsigned getWindowRows() const { return this->windowRows; }
+
+    /**
+     * @brief Add a sample to a pixel
+     *
+     * @param x the row
+     * @param y the column
+     * @param color the color of the sample
+     */
+    void accumulate(unsigned x, unsigned y, const glm::vec3 &color) {
+        glm::vec4 &pixel = samples[index(x, y)];
+        pixel.x += color.x;
+        pixel.y += color.y;
+        pixel.z += color.z;
+        pixel.w += 1;
+    }
+
+    /**
+     * @brief Replace the samples of a pixel by a single one
+     *
+     * @param x the row
+     * @param y the column
+     * @param color the color of the pixel
+     */
+    void set(unsigned x, unsigned y, const glm::vec3 &color) {
+        samples[index(x, y)] = glm::vec4(color, 1);
+    }
+
+    /**
+     * @brief The color of a pixel, the mean of its samples
+     *
+     * @param x the row
+     * @param y the column
+     * @return glm::vec3 black if the pixel has no sample
+     */
+    glm::vec3 get(unsigned x, unsigned y) const {
+        const glm::vec4 &pixel = samples[index(x, y)];
+        if (pixel.w == 0) return glm::vec3(0, 0, 0);
+        return glm::vec3(pixel.x, pixel.y, pixel.z) / pixel.w;
+    }
+
+    /**
+     * @brief The samples of the pixels of a row: the sums of their colors, and their numbers in w
+     *
+     * @param x the row
+     * @return const glm::vec4* the resY pixels of the row
+     */
+    const glm::vec4 *getRowSamples(unsigned x) const { return &samples[index(x, 0)]; }
+
+    /**
+     * @brief Get the number of samples of a pixel
+     *
+     * @param x the row
+     * @param y the column
+     * @return unsigned
+     */
+    unsigned getSampleCount(unsigned x, unsigned y) const { return samples[index(x, y)].w; }
+
+    /**
+     * @brief The colors of a row truncated to 8 bits, as RGBA
+     *
+     * @param x the row
+     * @param rgba the 4 * resY bytes of the row
+     */
+    void getRow(unsigned x, unsigned char *rgba) const {
+        for (unsigned y = 0; y < resY; ++y) {
+            const glm::vec3 color = get(x, y);
+            rgba[4 * y] = (unsigned char)color[0];
+            rgba[4 * y + 1] = (unsigned char)color[1];
+            rgba[4 * y + 2] = (unsigned char)color[2];
+            rgba[4 * y + 3] = (unsigned char)255;
+        }
+    }
+
+    /**
+     * @brief The linear colors of a row, neither clamped nor quantized, 1 being the white
+     *
+     * @param x the row
+     * @param rgb the 3 * resY floats of the row
+     */
+    void getRadianceRow(unsigned x, float *rgb) const {
+        for (unsigned y = 0; y < resY; ++y) {
+            const glm::vec3 color = get(x, y) / 255.0f;
+            rgb[3 * y] = color[0];
+            rgb[3 * y + 1] = color[1];
+            rgb[3 * y + 2] = color[2];
+        }
+    }
+
+    /**
+     * @brief Signal that the rows [xBegin, xEnd[ will not be modified anymore. A streamed
+     * framebuffer hands them to its sink and frees their slots.
+     *
+     * @param xBegin the first row
+     * @param xEnd the row after the last one
+     */
+    void completeRows(unsigned xBegin, unsigned xEnd) {
+        if (!sink) return;
+        for (unsigned x = xBegin; x < xEnd; ++x) {
+            sink(*this, x);
+            std::fill(samples.begin() + index(x, 0), samples.begin() + index(x, 0) + resY,
+                      glm::vec4(0, 0, 0, 0));
+        }
+    }
+
+    /**
+     * @brief Remove the samples of all the pixels
+     *
+     */
+    void clear() { std::fill(samples.begin(), samples.end(), glm::vec4(0, 0, 0, 0)); }
+
+    /**
+     * @brief Construct a new Framebuffer object holding the whole image, whose pixels have no
+     * sample
+     *
+     * @param rx the number of rows
+     * @param ry the number of columns
+     */
+    explicit Framebuffer(unsigned rx, unsigned ry)
+        : resX(rx), resY(ry), windowRows(rx), samples(rx * ry, glm::vec4(0, 0, 0, 0)) {}
+
+    /**
+     * @brief Construct a new streamed Framebuffer object
+     *
+     * @param rx the number of rows
+     * @param ry the number of columns
+     * @param window the number of rows held, the rows being written in order at most window rows
+     * after the first row which is not complete
+     * @param rowSink the function receiving the complete rows
+     */
+    explicit Framebuffer(unsigned rx, unsigned ry, unsigned window, RowSink rowSink)
+        : resX(rx),
+          resY(ry),
+          windowRows(std::max(1u, std::min(window, rx))),
+          samples(windowRows * ry, glm::vec4(0, 0, 0, 0)),
+          sink(rowSink) {}
+};
@@ -0,0 +1,185 @@
+/**
+ * @file FxaaFilter.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The FXAA filter, following the FXAA 3.11 quality algorithm of Timothy Lottes (NVIDIA)
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "FxaaFilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief The steps of the search of the ends of an edge, growing with the distance.
+ *
+ */
+constexpr unsigned SEARCH_STEPS[] = {1, 1, 1, 1, 1, 2, 2, 2, 2, 4, 8};
+
+}  // namespace
+
+void FxaaFilter::apply(const Framebuffer &image, Framebuffer &output) const {
+    const int resX = image.getResX();
+    const unsigned resY = image.getResY();
+    const unsigned stride = resY + 2;
+
+    // The luma of the pixels clamped to the white, the border repeating the pixels of the edges of
+    // the image, so that the neighbours of all the pixels are read the same way
+    std::vector<float> luma((resX + 2) * stride);
+#pragma omp parallel for
+    for (int x = 0; x < resX; ++x) {
+        const glm::vec4 *pixels = image.getRowSamples(x);
+        float *row = &luma[(x + 1) * stride + 1];
+#pragma omp simd
+        for (unsigned y = 0; y < resY; ++y) {
+            const float count = pixels[y].w;
+            const float scale = 1.0f / (255.0f * (count > 1.0f ? count : 1.0f));
+            const float value =
+                scale * (0.299f * pixels[y].x + 0.587f * pixels[y].y + 0.114f * pixels[y].z);
+            row[y] = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        }
+        row[-1] = row[0];
+        row[resY] = row[resY - 1];
+    }
+    std::copy(luma.begin() + stride, luma.begin() + 2 * stride, luma.begin());
+    std::copy(luma.end() - 2 * stride, luma.end() - stride, luma.end() - stride);
+
+    const int bandRows = output.getWindowRows();
+    for (int xBegin = 0; xBegin < resX; xBegin += bandRows) {
+        const int xEnd = std::min(xBegin + bandRows, resX);
+#pragma omp parallel
+        {
+            std::vector<unsigned> edges;
+#pragma omp for schedule(dynamic, 1)
+            for (int x = xBegin; x < xEnd; ++x) filterRow(image, luma, x, edges, output);
+        }
+        output.completeRows(xBegin, xEnd);
+    }
+}
+
+void FxaaFilter::filterRow(const Framebuffer &image, const std::vector<float> &luma, unsigned x,
+                           std::vector<unsigned> &edges, Framebuffer &output) const {
+    const int resX = image.getResX();
+    const int resY = image.getResY();
+    const int row = x;
+    const unsigned stride = resY + 2;
+    const float *north = &luma[x * stride + 1];
+    const float *middle = north + stride;
+    const float *south = middle + stride;
+
+    // The pixels contrasting with their neighbours
+    edges.resize(resY);
+    unsigned edgeCount = 0;
+    for (int y = 0; y < resY; ++y) output.set(x, y, image.get(x, y));
+#pragma omp simd
+    for (int y = 0; y < resY; ++y) {
+        const float lumaMax = std::max(std::max(std::max(north[y], south[y]),
+                                                std::max(middle[y - 1], middle[y + 1])),
+                                       middle[y]);
+        const float lumaMin = std::min(std::min(std::min(north[y], south[y]),
+                                                std::min(middle[y - 1], middle[y + 1])),
+                                       middle[y]);
+        edges[y] = lumaMax - lumaMin >= std::max(edgeThresholdMin, lumaMax * edgeThreshold);
+    }
+    for (int y = 0; y < resY; ++y) {
+        if (edges[y]) edges[edgeCount++] = y;
+    }
+
+    // The luma of a pixel, the pixels out of the image repeating its edges
+    auto lumaAt = [&](int px, int py) {
+        px = std::min(std::max(px, -1), resX);
+        py = std::min(std::max(py, -1), resY);
+        return luma[(px + 1) * stride + py + 1];
+    };
+
+    for (unsigned edgeId = 0; edgeId < edgeCount; ++edgeId) {
+        const int y = edges[edgeId];
+        const float lumaM = middle[y];
+        const float lumaN = north[y];
+        const float lumaS = south[y];
+        const float lumaW = middle[y - 1];
+        const float lumaE = middle[y + 1];
+        const float lumaNW = north[y - 1];
+        const float lumaNE = north[y + 1];
+        const float lumaSW = south[y - 1];
+        const float lumaSE = south[y + 1];
+        const float range = std::max(std::max(std::max(lumaN, lumaS), std::max(lumaW, lumaE)),
+                                     lumaM) -
+                            std::min(std::min(std::min(lumaN, lumaS), std::min(lumaW, lumaE)),
+                                     lumaM);
+
+        // Blending of the isolated pixels, from the contrast with the average of the neighbours
+        const float lumaAverage =
+            (2.0f * (lumaN + lumaS + lumaW + lumaE) + lumaNW + lumaNE + lumaSW + lumaSE) / 12.0f;
+        const float subpixelContrast = std::min(std::abs(lumaAverage - lumaM) / range, 1.0f);
+        const float subpixelBlend = (-2.0f * subpixelContrast + 3.0f) * subpixelContrast *
+                                    subpixelContrast;
+        const float subpixelOffset = subpixelBlend * subpixelBlend * subpixelQuality;
+
+        // An edge along the row when the luma varies from the row above to the row below
+        const float edgeAlongRow = std::abs(lumaNW - 2.0f * lumaW + lumaSW) +
+                                   2.0f * std::abs(lumaN - 2.0f * lumaM + lumaS) +
+                                   std::abs(lumaNE - 2.0f * lumaE + lumaSE);
+        const float edgeAlongColumn = std::abs(lumaNW - 2.0f * lumaN + lumaNE) +
+                                      2.0f * std::abs(lumaW - 2.0f * lumaM + lumaE) +
+                                      std::abs(lumaSW - 2.0f * lumaS + lumaSE);
+        const bool alongRow = edgeAlongRow >= edgeAlongColumn;
+
+        // The side of the edge with the steepest gradient
+        const float luma1 = alongRow ? lumaN : lumaW;
+        const float luma2 = alongRow ? lumaS : lumaE;
+        const float gradient1 = std::abs(luma1 - lumaM);
+        const float gradient2 = std::abs(luma2 - lumaM);
+        const int side = gradient1 >= gradient2 ? -1 : 1;
+        const float lumaSide = side < 0 ? luma1 : luma2;
+        const float gradientScaled = 0.25f * std::max(gradient1, gradient2);
+        const float lumaLocalAverage = 0.5f * (lumaSide + lumaM);
+
+        // Follow the edge, between the pixel and its neighbour on the side, until the luma varies
+        auto edgeLuma = [&](int position) {
+            if (alongRow) return 0.5f * (lumaAt(row, position) + lumaAt(row + side, position)) -
+                                 lumaLocalAverage;
+            return 0.5f * (lumaAt(position, y) + lumaAt(position, y + side)) - lumaLocalAverage;
+        };
+        const int center = alongRow ? y : row;
+        int position1 = center - 1;
+        int position2 = center + 1;
+        float delta1 = edgeLuma(position1);
+        float delta2 = edgeLuma(position2);
+        bool reached1 = std::abs(delta1) >= gradientScaled;
+        bool reached2 = std::abs(delta2) >= gradientScaled;
+        for (unsigned step : SEARCH_STEPS) {
+            if (reached1 && reached2) break;
+            if (!reached1) {
+                position1 -= step;
+                delta1 = edgeLuma(position1);
+                reached1 = std::abs(delta1) >= gradientScaled;
+            }
+            if (!reached2) {
+                position2 += step;
+                delta2 = edgeLuma(position2);
+                reached2 = std::abs(delta2) >= gradientScaled;
+            }
+        }
+
+        // The pixel is blended according to its distance to the closest end of the edge, if the
+        // luma at this end varies towards the luma of the pixel
+        const int distance1 = center - position1;
+        const int distance2 = position2 - center;
+        const bool closerTo1 = distance1 < distance2;
+        const float distance = std::min(distance1, distance2);
+        const float edgeOffset = 0.5f - distance / (distance1 + distance2);
+        const bool correctVariation =
+            ((closerTo1 ? delta1 : delta2) < 0.0f) != (lumaM < lumaLocalAverage);
+        const float offset = std::max(correctVariation ? edgeOffset : 0.0f, subpixelOffset);
+
+        const int neighbourX = alongRow ? std::min(std::max(row + side, 0), resX - 1) : row;
+        const int neighbourY = alongRow ? y : std::min(std::max(y + side, 0), resY - 1);
+        const glm::vec3 color = image.get(x, y);
+        output.set(x, y, color + (image.get(neighbourX, neighbourY) - color) * offset);
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ * @file FxaaFilter.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A post-process anti-aliasing of the rendered images, smoothing their edges without
+ * casting more rays
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <vector>
+
+#include "Framebuffer.hpp"
+
+/**
+ * @brief The Fast Approximate Anti-Aliasing (FXAA) of Timothy Lottes. The pixels whose luma
+ * contrasts with their neighbours are on an edge: the edge is followed on both sides to find its
+ * ends, and the pixel is blended with its neighbour across the edge according to its position along
+ * the edge, as a staircase would be covered by the true edge.
+ *
+ * The luma and the contrast test are computed for whole rows with vectorized loops, the few pixels
+ * of the edges being then handled one by one.
+ * @class FxaaFilter
+ */
+class FxaaFilter {
+protected:
+    /**
+     * @brief The minimum contrast of an edge, relatively to the brightest luma of the neighbourhood
+     *
+     */
+    float edgeThreshold;
+
+    /**
+     * @brief The minimum contrast of an edge, so that the dark areas are not processed
+     *
+     */
+    float edgeThresholdMin;
+
+    /**
+     * @brief The strength of the blending of the isolated pixels (0 to 1)
+     *
+     */
+    float subpixelQuality;
+
+    /**
+     * @brief Filter a row
+     *
+     * @param image the image
+     * @param luma the luma of the image, with a border of one pixel
+     * @param x the row
+     * @param edges the columns of the pixels of the row on an edge, as a buffer
+     * @param output the image receiving the row
+     */
+    void filterRow(const Framebuffer &image, const std::vector<float> &luma, unsigned x,
+                   std::vector<unsigned> &edges, Framebuffer &output) const;
+
+public:
+    /**
+     * @brief Get the Edge Threshold object
+     *
+     * @return float
+     */
+    float getEdgeThreshold() const { return this->edgeThreshold; }
+
+    /**
+     * @brief Set the Edge Threshold object
+     *
+     * @param threshold the minimum contrast of an edge relatively to the brightest luma, 1/8 for a
+     * high quality and 1/4 for a fast filter
+     */
+    void setEdgeThreshold(const float &threshold) { this->edgeThreshold = threshold; }
+
+    /**
+     * @brief Get the Edge Threshold Min object
+     *
+     * @return float
+     */
+    float getEdgeThresholdMin() const { return this->edgeThresholdMin; }
+
+    /**
+     * @brief Set the Edge Threshold Min object
+     *
+     * @param threshold the minimum contrast of an edge, the luma going from 0 to 1
+     */
+    void setEdgeThresholdMin(const float &threshold) { this->edgeThresholdMin = threshold; }
+
+    /**
+     * @brief Get the Subpixel Quality object
+     *
+     * @return float
+     */
+    float getSubpixelQuality() const { return this->subpixelQuality; }
+
+    /**
+     * @brief Set the Subpixel Quality object
+     *
+     * @param quality 0 to only smooth the long edges, 1 to blur the isolated pixels the most
+     */
+    void setSubpixelQuality(const float &quality) { this->subpixelQuality = quality; }
+
+    /**
+     * @brief Filter an image. The rows of the output are completed by bands of its window of rows,
+     * so that a streamed output is written as the filter goes.
+     *
+     * @param image the whole image
+     * @param output the filtered image, of the resolution of image, whose pixels have no sample
+     */
+    void apply(const Framebuffer &image, Framebuffer &output) const;
+
+    /**
+     * @brief Construct a new Fxaa Filter object with the high quality settings of FXAA 3.11
+     *
+     */
+    explicit FxaaFilter()
+        : edgeThreshold(0.125f), edgeThresholdMin(0.0312f), subpixelQuality(0.75f) {}
+};
@@ -0,0 +1,177 @@
+/**
+ * @file HdrStreamWriter.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The PFM and OpenEXR writers, following the format descriptions of Paul Debevec (PFM) and
+ * of the OpenEXR file layout documentation
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "HdrStreamWriter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+void appendLittleEndian(std::vector<unsigned char> &out, uint64_t value, unsigned bytes) {
+    for (unsigned byte = 0; byte < bytes; ++byte) out.push_back((value >> (8 * byte)) & 0xFF);
+}
+
+void appendFloat(std::vector<unsigned char> &out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    appendLittleEndian(out, bits, 4);
+}
+
+/**
+ * @brief Convert a float to a half float, rounding to the nearest even
+ *
+ */
+uint16_t toHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t floatExponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // Infinity and NaN
+    if (floatExponent == 0xFF) return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+
+    const int exponent = (int)floatExponent - 127 + 15;
+    if (exponent >= 31) return sign | 0x7C00;
+    if (exponent <= 0) {
+        // Subnormal half, or 0
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        const unsigned shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) ++half;
+        return sign | half;
+    }
+
+    // A carry of the rounding goes to the exponent, up to infinity
+    uint32_t half = (exponent << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ++half;
+    return sign | half;
+}
+
+void appendAttribute(std::vector<unsigned char> &header, const std::string &name,
+                     const std::string &type, const std::vector<unsigned char> &value) {
+    header.insert(header.end(), name.begin(), name.end());
+    header.push_back(0);
+    header.insert(header.end(), type.begin(), type.end());
+    header.push_back(0);
+    appendLittleEndian(header, value.size(), 4);
+    header.insert(header.end(), value.begin(), value.end());
+}
+
+}  // namespace
+
+bool HdrStreamWriter::isHdrFilename(const std::string &filename) {
+    if (filename.size() < 4) return false;
+    std::string extension = filename.substr(filename.size() - 4);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return extension == ".pfm" || extension == ".exr";
+}
+
+HdrStreamWriter::HdrStreamWriter(const std::string &filename, unsigned w, unsigned h)
+    : file(filename, std::ios::binary), width(w), height(h), rowCount(0) {
+    if (!isHdrFilename(filename)) {
+        throw std::invalid_argument("The image " + filename + " is neither a PFM nor an EXR file");
+    }
+    if (!file.is_open()) throw std::runtime_error("Cannot write the image " + filename);
+
+    std::string extension = filename.substr(filename.size() - 4);
+    format = (extension[1] == 'p' || extension[1] == 'P') ? PFM : EXR;
+    if (format == PFM) {
+        writeHeaderPFM();
+    } else {
+        writeHeaderEXR();
+    }
+}
+
+void HdrStreamWriter::writeHeaderPFM() {
+    // A negative scale for little endian floats
+    const std::string header =
+        "PF\n" + std::to_string(width) + " " + std::to_string(height) + "\n-1.0\n";
+    file.write(header.data(), header.size());
+    dataOffset = header.size();
+}
+
+void HdrStreamWriter::writeHeaderEXR() {
+    std::vector<unsigned char> header;
+    appendLittleEndian(header, 20000630, 4);  // magic number
+    appendLittleEndian(header, 2, 4);         // version 2, single part scanline image
+
+    // Half channels, in alphabetical order
+    std::vector<unsigned char> channels;
+    for (char name : {'B', 'G', 'R'}) {
+        channels.push_back(name);
+        channels.push_back(0);
+        appendLittleEndian(channels, 1, 4);  // half
+        appendLittleEndian(channels, 0, 4);  // linear flag and reserved bytes
+        appendLittleEndian(channels, 1, 4);  // sampling
+        appendLittleEndian(channels, 1, 4);
+    }
+    channels.push_back(0);
+    appendAttribute(header, "channels", "chlist", channels);
+    appendAttribute(header, "compression", "compression", {0});
+
+    std::vector<unsigned char> window;
+    appendLittleEndian(window, 0, 4);
+    appendLittleEndian(window, 0, 4);
+    appendLittleEndian(window, width - 1, 4);
+    appendLittleEndian(window, height - 1, 4);
+    appendAttribute(header, "dataWindow", "box2i", window);
+    appendAttribute(header, "displayWindow", "box2i", window);
+    appendAttribute(header, "lineOrder", "lineOrder", {0});  // increasing y
+
+    std::vector<unsigned char> one, center;
+    appendFloat(one, 1.0f);
+    appendFloat(center, 0.0f);
+    appendFloat(center, 0.0f);
+    appendAttribute(header, "pixelAspectRatio", "float", one);
+    appendAttribute(header, "screenWindowCenter", "v2f", center);
+    appendAttribute(header, "screenWindowWidth", "float", one);
+    header.push_back(0);
+
+    // Offset of each row: the rows have the same size, the y and the size preceding the data
+    const uint64_t rowSize = 8 + 6 * (uint64_t)width;
+    dataOffset = header.size() + 8 * (uint64_t)height;
+    for (unsigned y = 0; y < height; ++y) appendLittleEndian(header, dataOffset + y * rowSize, 8);
+    file.write((const char *)header.data(), header.size());
+}
+
+void HdrStreamWriter::writeRow(const float *rgb) {
+    if (rowCount == height) throw std::runtime_error("Too many rows for the image");
+
+    rowBytes.clear();
+    if (format == PFM) {
+        // The rows of a PFM file go from the bottom to the top of the image
+        for (unsigned id = 0; id < 3 * width; ++id) appendFloat(rowBytes, rgb[id]);
+        file.seekp(dataOffset + (uint64_t)(height - 1 - rowCount) * rowBytes.size());
+    } else {
+        appendLittleEndian(rowBytes, rowCount, 4);
+        appendLittleEndian(rowBytes, 6 * (uint64_t)width, 4);
+        for (int channel = 2; channel >= 0; --channel) {
+            for (unsigned y = 0; y < width; ++y) {
+                appendLittleEndian(rowBytes, toHalf(rgb[3 * y + channel]), 2);
+            }
+        }
+    }
+    file.write((const char *)rowBytes.data(), rowBytes.size());
+    ++rowCount;
+}
+
+void HdrStreamWriter::close() {
+    if (rowCount != height) throw std::runtime_error("The image is incomplete");
+    file.close();
+}
@@ -0,0 +1,83 @@
+/**
+ * @file HdrStreamWriter.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Writers of the linear colors of the rendered images, without compression nor clamping,
+ * for the compositing tools
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Writes a RGB image with float colors row by row, in one of the formats:
+ * - PFM (Portable Float Map), 32 bits floats
+ * - OpenEXR, 16 bits floats (half), uncompressed scanlines
+ *
+ * The size of each row in the file is fixed, so that the rows are written as soon as they are
+ * given and are never held in memory.
+ * @class HdrStreamWriter
+ */
+class HdrStreamWriter {
+public:
+    enum Format { PFM, EXR };
+
+protected:
+    std::ofstream file;
+    Format format;
+    unsigned width;
+    unsigned height;
+    unsigned rowCount;
+
+    /**
+     * @brief The position of the first row in the file.
+     *
+     */
+    uint64_t dataOffset;
+
+    /**
+     * @brief The bytes of a row, reused from row to row.
+     *
+     */
+    std::vector<unsigned char> rowBytes;
+
+    void writeHeaderPFM();
+    void writeHeaderEXR();
+
+public:
+    /**
+     * @brief Tells whether a file name has the extension of a format of the writer (.pfm or .exr)
+     *
+     * @param filename the name of the file
+     * @return true if the image can be written by a HdrStreamWriter
+     */
+    static bool isHdrFilename(const std::string &filename);
+
+    /**
+     * @brief Add the next row, from the top of the image.
+     *
+     * @param rgb the width pixels of the row, 3 floats per pixel
+     */
+    void writeRow(const float *rgb);
+
+    /**
+     * @brief End the image. All its rows must have been written.
+     *
+     */
+    void close();
+
+    /**
+     * @brief Construct a new Hdr Stream Writer object and write the header of the image.
+     *
+     * @param filename the name of the file, whose extension gives the format
+     * @param w the width of the image (in pixels)
+     * @param h the height of the image (in pixels)
+     */
+    explicit HdrStreamWriter(const std::string &filename, unsigned w, unsigned h);
+};
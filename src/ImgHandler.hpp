@@ -16,6 +16,8 @@
 
 #include <glm/vec3.hpp>
 
+#include "Framebuffer.hpp"
+#include "PngStreamWriter.hpp"
 #include "lodepng/lodepng.h"
 
 /**
@@ -56,8 +58,8 @@ public:
      * @param height the height of the image (in pixels)
      * @param width the
      */
-    void writePNG(const std::string& filename, std::vector<unsigned char> image, unsigned& height,
-                  unsigned& width) {
+    void writePNG(const std::string& filename, const std::vector<unsigned char>& image,
+                  unsigned height, unsigned width) {
         // Encode the image
         unsigned error = lodepng::encode(filename, image, width, height);
 
@@ -66,4 +68,22 @@ public:
             std::cout << "encoder error " << error << ": " << lodepng_error_text(error)
                       << std::endl;
     }
+
+    /**
+     * @brief A method to write a framebuffer to PNG, its rows being the rows of the image. The
+     * colors are truncated to 8 bits. The rows are compressed one by one, without copying the
+     * image.
+     *
+     * @param filename the name of the file
+     * @param framebuffer the rendered image, which must not be streamed
+     */
+    void writePNG(const std::string& filename, const Framebuffer& framebuffer) {
+        PngStreamWriter writer(filename, framebuffer.getResY(), framebuffer.getResX());
+        std::vector<unsigned char> row(4 * framebuffer.getResY());
+        for (unsigned x = 0; x < framebuffer.getResX(); ++x) {
+            framebuffer.getRow(x, row.data());
+            writer.writeRow(row.data());
+        }
+        writer.close();
+    }
 };
\ No newline at end of file
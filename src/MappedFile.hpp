@@ -0,0 +1,85 @@
+/**
+ * @file MappedFile.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A file mapped in memory, to read large files without copying them
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A file mapped in memory, read only, unmapped when the object is destroyed. The pages are
+ * loaded by the system as they are read.
+ * @class MappedFile
+ */
+class MappedFile {
+protected:
+    const char *data;
+    size_t size;
+    bool opened;
+
+public:
+    /**
+     * @brief Get the content of the file
+     *
+     * @return const char* nullptr if the file is empty or could not be mapped
+     */
+    const char *getData() const { return this->data; }
+
+    /**
+     * @brief Get the size of the file in bytes
+     *
+     * @return size_t
+     */
+    size_t getSize() const { return this->size; }
+
+    /**
+     * @brief Tells whether the file could be read
+     *
+     * @return true if the file exists and was mapped, or is empty
+     */
+    bool isOpen() const { return this->opened; }
+
+    /**
+     * @brief Construct a new Mapped File object
+     *
+     * @param filename the name of the file
+     * @param sequential true if the file is read from its start to its end, so that the next
+     * pages are loaded in advance
+     */
+    explicit MappedFile(const std::string &filename, bool sequential = true)
+        : data(nullptr), size(0), opened(false) {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        opened = true;
+        struct stat status;
+        if (fstat(fd, &status) == 0 && status.st_size > 0) {
+            void *mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                data = static_cast<const char *>(mapping);
+                size = status.st_size;
+                if (sequential) madvise(mapping, size, MADV_SEQUENTIAL);
+            } else {
+                opened = false;
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) munmap(const_cast<char *>(data), size);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+};
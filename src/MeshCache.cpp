@@ -0,0 +1,231 @@
+/**
+ * @file MeshCache.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A binary copy of the meshes read from .obj files, to skip the parsing and the building of
+ * the BVH on the next runs
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "MeshCache.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include "MappedFile.hpp"
+#include "ObjParser.hpp"
+
+namespace {
+
+/**
+ * @brief The first bytes of a cache file, "RTMC".
+ *
+ */
+constexpr uint32_t MAGIC = 0x434D5452;
+
+/**
+ * @brief A value read back differently on a machine with another byte order.
+ *
+ */
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+/**
+ * @brief The header of a cache file, followed by the vertices (3 floats each), the triangles
+ * (3 indices each), their normals (3 floats each), their ids when added (1 index each), the
+ * nodes of the BVH (6 floats and 2 indices each) and the primitives of its leaves (1 index each).
+ *
+ */
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t vertexCount;
+    uint64_t objSize;
+    int64_t objTime;
+    uint32_t triangleCount;
+    uint32_t nodeCount;
+    uint32_t primIdCount;
+    uint32_t padding;
+};
+
+constexpr size_t NODE_SIZE = 6 * sizeof(float) + 2 * sizeof(uint32_t);
+
+/**
+ * @brief Get the size and the modification time of a file, in nanoseconds
+ *
+ * @return true if the file exists
+ */
+bool stamp(const std::string &filename, uint64_t &size, int64_t &time) {
+    struct stat status;
+    if (stat(filename.c_str(), &status) != 0) return false;
+    size = status.st_size;
+    // in nanoseconds, so that an edit within the same second is noticed
+    time = (int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+    return true;
+}
+
+/**
+ * @brief Copy the next bytes of the file into an array
+ *
+ * @return const char* the byte after the copied ones
+ */
+template <typename T>
+const char *readArray(const char *p, std::vector<T> &array, size_t count) {
+    array.resize(count);
+    std::memcpy(array.data(), p, count * sizeof(T));
+    return p + count * sizeof(T);
+}
+
+/**
+ * @brief Tells whether the BVH read from a file can be walked safely: the children of a node come
+ * after it, within the nodes, and not deeper than BVH::MAX_DEPTH for the traversal stacks, and the
+ * leaves and the primitives are within the triangles.
+ *
+ * @param nodes the nodes, the root being the first one
+ * @param primIds the primitives of the leaves
+ * @param triangleCount the number of triangles of the mesh
+ * @return true if the BVH is valid
+ */
+bool isValid(const std::vector<BVH::Node> &nodes, const std::vector<unsigned> &primIds,
+             uint64_t triangleCount) {
+    if (primIds.size() != triangleCount) return false;
+    for (unsigned id : primIds) {
+        if (id >= triangleCount) return false;
+    }
+    std::vector<unsigned> depths(nodes.size(), 0);
+    for (uint64_t id = 0; id < nodes.size(); ++id) {
+        const BVH::Node &node = nodes[id];
+        if (node.isLeaf()) {
+            if ((uint64_t)node.first + node.count > primIds.size()) return false;
+            continue;
+        }
+        if (node.first <= id || (uint64_t)node.first + 1 >= nodes.size()) return false;
+        if (depths[id] >= BVH::MAX_DEPTH) return false;
+        for (unsigned child = node.first; child <= node.first + 1; ++child) {
+            depths[child] = std::max(depths[child], depths[id] + 1);
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void writeArray(std::ofstream &file, const std::vector<T> &array) {
+    file.write(reinterpret_cast<const char *>(array.data()), array.size() * sizeof(T));
+}
+
+}  // namespace
+
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "the vertices are copied as 3 floats");
+
+std::shared_ptr<TriangleMesh> MeshCache::load(const std::string &objFilename) noexcept(false) {
+    const std::string cacheFilename = getCacheFilename(objFilename);
+    std::shared_ptr<TriangleMesh> mesh = read(cacheFilename, objFilename);
+    if (mesh) return mesh;
+
+    ObjParser objParser;
+    PolygonMesh polyMesh = objParser.readObj(objFilename);
+    mesh = std::make_shared<TriangleMesh>(polyMesh);
+    write(cacheFilename, objFilename, *mesh);
+    return mesh;
+}
+
+std::shared_ptr<TriangleMesh> MeshCache::read(const std::string &cacheFilename,
+                                              const std::string &objFilename) {
+    uint64_t objSize;
+    int64_t objTime;
+    if (!stamp(objFilename, objSize, objTime)) return nullptr;
+    MappedFile file(cacheFilename);
+    if (file.getSize() < sizeof(Header)) return nullptr;
+
+    Header header;
+    std::memcpy(&header, file.getData(), sizeof(Header));
+    if (header.magic != MAGIC || header.version != VERSION ||
+        header.byteOrder != BYTE_ORDER_MARK || header.objSize != objSize ||
+        header.objTime != objTime) {
+        return nullptr;
+    }
+    const uint64_t expectedSize = sizeof(Header) + header.vertexCount * sizeof(glm::vec3) +
+                                  header.triangleCount * (3 * sizeof(uint32_t) +
+                                                          sizeof(glm::vec3) + sizeof(uint32_t)) +
+                                  header.nodeCount * NODE_SIZE +
+                                  header.primIdCount * sizeof(uint32_t);
+    if (file.getSize() != expectedSize) return nullptr;
+
+    auto mesh = std::make_shared<TriangleMesh>();
+    const char *p = file.getData() + sizeof(Header);
+    p = readArray(p, mesh->vertices, header.vertexCount);
+    p = readArray(p, mesh->indices, 3 * header.triangleCount);
+    p = readArray(p, mesh->normals, header.triangleCount);
+    p = readArray(p, mesh->addedIds, header.triangleCount);
+    for (unsigned id : mesh->indices) {
+        if (id >= header.vertexCount) return nullptr;
+    }
+    for (unsigned id : mesh->addedIds) {
+        if (id >= header.triangleCount) return nullptr;
+    }
+
+    std::vector<BVH::Node> nodes(header.nodeCount);
+    for (BVH::Node &node : nodes) {
+        std::memcpy(&node.bounds.min, p, sizeof(glm::vec3));
+        std::memcpy(&node.bounds.max, p + sizeof(glm::vec3), sizeof(glm::vec3));
+        uint32_t range[2];
+        std::memcpy(range, p + 2 * sizeof(glm::vec3), sizeof(range));
+        node.first = range[0];
+        node.count = range[1];
+        p += NODE_SIZE;
+    }
+    std::vector<unsigned> primIds;
+    readArray(p, primIds, header.primIdCount);
+    if (!isValid(nodes, primIds, header.triangleCount)) return nullptr;
+    mesh->bvh.setNodes(std::move(nodes), std::move(primIds));
+
+    mesh->buildEdges();
+    return mesh;
+}
+
+bool MeshCache::write(const std::string &cacheFilename, const std::string &objFilename,
+                      const TriangleMesh &mesh) {
+    Header header = {};
+    if (!stamp(objFilename, header.objSize, header.objTime)) return false;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.vertexCount = mesh.vertices.size();
+    header.triangleCount = mesh.normals.size();
+    header.nodeCount = mesh.bvh.getNodes().size();
+    header.primIdCount = mesh.bvh.getPrimIds().size();
+
+    const std::string tmpFilename = cacheFilename + ".tmp";
+    {
+        std::ofstream file(tmpFilename, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        writeArray(file, mesh.vertices);
+        writeArray(file, mesh.indices);
+        writeArray(file, mesh.normals);
+        writeArray(file, mesh.addedIds);
+        for (const BVH::Node &node : mesh.bvh.getNodes()) {
+            const uint32_t range[2] = {node.first, node.count};
+            file.write(reinterpret_cast<const char *>(&node.bounds.min), sizeof(glm::vec3));
+            file.write(reinterpret_cast<const char *>(&node.bounds.max), sizeof(glm::vec3));
+            file.write(reinterpret_cast<const char *>(range), sizeof(range));
+        }
+        writeArray(file, mesh.bvh.getPrimIds());
+        if (!file) {
+            file.close();
+            std::remove(tmpFilename.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmpFilename.c_str(), cacheFilename.c_str()) != 0) {
+        std::remove(tmpFilename.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file MeshCache.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A binary copy of the meshes read from .obj files, to skip the parsing and the building of
+ * the BVH on the next runs
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Object/TriangleMesh.hpp"
+
+/**
+ * @class MeshCache
+ * @brief Loads the meshes of .obj files through a cache file written next to them. The cache file
+ * holds the vertices, the triangles and the BVH of the mesh, already in the order of its leaves,
+ * so that loading the mesh only copies arrays out of the mapped file.
+ *
+ * The cache file starts with a header holding a version number, the byte order of the machine and
+ * the size and modification time of the .obj file: a cache file which does not match them is
+ * ignored and written again.
+ */
+class MeshCache {
+public:
+    /**
+     * @brief The version of the format of the cache files, to increase when it changes.
+     *
+     */
+    static constexpr unsigned VERSION = 2;
+
+    /**
+     * @brief Get the name of the cache file of a .obj file
+     *
+     * @param objFilename the name of the .obj file
+     * @return std::string
+     */
+    static std::string getCacheFilename(const std::string &objFilename) {
+        return objFilename + ".meshcache";
+    }
+
+    /**
+     * @brief Load a mesh from its cache file if it is up to date, else parse the .obj file, build
+     * the mesh and write its cache file. The mesh is loaded even if the cache file cannot be
+     * written.
+     *
+     * @param objFilename the name of the .obj file
+     * @return std::shared_ptr<TriangleMesh>
+     * @throw std::runtime_error if the .obj file is not valid
+     */
+    static std::shared_ptr<TriangleMesh> load(const std::string &objFilename) noexcept(false);
+
+    /**
+     * @brief Read a mesh from a cache file
+     *
+     * @param cacheFilename the name of the cache file
+     * @param objFilename the name of the .obj file, whose size and modification time must match
+     * the ones of the cache file
+     * @return std::shared_ptr<TriangleMesh> nullptr if the cache file is missing, stale or invalid
+     */
+    static std::shared_ptr<TriangleMesh> read(const std::string &cacheFilename,
+                                              const std::string &objFilename);
+
+    /**
+     * @brief Write the cache file of a mesh. The file is written under a temporary name then
+     * renamed, so that a run stopped while writing does not leave a truncated cache file.
+     *
+     * @param cacheFilename the name of the cache file
+     * @param objFilename the name of the .obj file the mesh was read from
+     * @param mesh the built mesh
+     * @return true if the file was written
+     */
+    static bool write(const std::string &cacheFilename, const std::string &objFilename,
+                      const TriangleMesh &mesh);
+};
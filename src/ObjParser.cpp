@@ -0,0 +1,262 @@
+/**
+ * @file ObjParser.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A parser for .obj files, reading the file in parallel.
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "ObjParser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "MappedFile.hpp"
+
+namespace {
+
+/**
+ * @brief The size of the chunks of the file parsed by each thread.
+ *
+ */
+constexpr size_t CHUNK_SIZE = 1 << 20;
+
+/**
+ * @brief The content of a chunk of lines. The indices of the corners are 0-based, -1 for a
+ * missing index. The relative indices are counted from the start of the chunk and listed in
+ * relativeSlots, since the number of elements in the previous chunks is not known yet.
+ *
+ */
+struct Chunk {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> textureCoordinates;
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned> faceSizes;
+    /**
+     * @brief The position, texture coordinates and normal indices of each corner.
+     *
+     */
+    std::vector<int> corners;
+    std::vector<unsigned> relativeSlots;
+};
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+const char *skipBlanks(const char *p, const char *end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+}
+
+/**
+ * @brief Parse a float written in decimal, with an optional exponent. The digits are gathered in
+ * an integer, which is scaled by an exact power of 10 when possible, so that the usual values are
+ * correctly rounded.
+ *
+ * @param p the first character, after the blanks
+ * @param end the end of the line
+ * @param value the parsed float
+ * @return const char* the character after the float
+ */
+const char *parseFloat(const char *p, const char *end, float &value) {
+    static const double POWERS[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    for (; p < end && isDigit(*p); ++p) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += mantissa != 0;
+        } else {
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && isDigit(*p); ++p) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+                --exponent;
+            }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) negativeExponent = *p++ == '-';
+        int written = 0;
+        for (; p < end && isDigit(*p); ++p) written = std::min(written * 10 + (*p - '0'), 10000);
+        exponent += negativeExponent ? -written : written;
+    }
+
+    double result = mantissa;
+    if (exponent >= -22 && exponent <= 22 && mantissa < (uint64_t(1) << 53)) {
+        result = exponent < 0 ? result / POWERS[-exponent] : result * POWERS[exponent];
+    } else {
+        result *= std::pow(10.0, exponent);
+    }
+    value = negative ? -result : result;
+    return p;
+}
+
+const char *parseInt(const char *p, const char *end, int &value, bool &found) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    found = p < end && isDigit(*p);
+    int result = 0;
+    for (; p < end && isDigit(*p); ++p) result = result * 10 + (*p - '0');
+    value = negative ? -result : result;
+    return p;
+}
+
+/**
+ * @brief Parse the faces and the vertices of whole lines
+ *
+ * @param p the first character of the first line
+ * @param end the character after the last line
+ * @param chunk the content of the lines
+ */
+void parseLines(const char *p, const char *end, Chunk &chunk) {
+    while (p < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+        p = skipBlanks(p, lineEnd);
+
+        if (lineEnd - p > 2 && p[0] == 'v' && isBlank(p[1])) {
+            glm::vec3 position;
+            p += 1;
+            for (int axis = 0; axis < 3; ++axis) {
+                p = parseFloat(skipBlanks(p, lineEnd), lineEnd, position[axis]);
+            }
+            chunk.positions.push_back(position);
+        } else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2])) {
+            glm::vec2 coordinates;
+            p = parseFloat(skipBlanks(p + 2, lineEnd), lineEnd, coordinates[0]);
+            parseFloat(skipBlanks(p, lineEnd), lineEnd, coordinates[1]);
+            chunk.textureCoordinates.push_back(coordinates);
+        } else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2])) {
+            glm::vec3 normal;
+            p += 2;
+            for (int axis = 0; axis < 3; ++axis) {
+                p = parseFloat(skipBlanks(p, lineEnd), lineEnd, normal[axis]);
+            }
+            chunk.normals.push_back(normal);
+        } else if (lineEnd - p > 2 && p[0] == 'f' && isBlank(p[1])) {
+            // Each corner is v, v/vt, v//vn or v/vt/vn
+            const int counts[3] = {(int)chunk.positions.size(),
+                                   (int)chunk.textureCoordinates.size(),
+                                   (int)chunk.normals.size()};
+            unsigned cornerNb = 0;
+            for (p = skipBlanks(p + 1, lineEnd); p < lineEnd; p = skipBlanks(p, lineEnd)) {
+                int ids[3] = {0, 0, 0};
+                bool found[3] = {false, false, false};
+                p = parseInt(p, lineEnd, ids[0], found[0]);
+                for (int attribute = 1; attribute < 3 && p < lineEnd && *p == '/'; ++attribute) {
+                    p = parseInt(p + 1, lineEnd, ids[attribute], found[attribute]);
+                }
+                if (!found[0]) break;
+                for (int attribute = 0; attribute < 3; ++attribute) {
+                    if (ids[attribute] < 0) {
+                        chunk.relativeSlots.push_back(chunk.corners.size());
+                        chunk.corners.push_back(counts[attribute] + ids[attribute]);
+                    } else {
+                        chunk.corners.push_back(found[attribute] ? ids[attribute] - 1 : -1);
+                    }
+                }
+                ++cornerNb;
+                while (p < lineEnd && !isBlank(*p)) ++p;
+            }
+            chunk.faceSizes.push_back(cornerNb);
+        }
+        p = lineEnd + 1;
+    }
+}
+
+}  // namespace
+
+PolygonMesh ObjParser::readObj(std::string filename) noexcept(false) {
+    MappedFile file(filename);
+    if (!file.isOpen()) {
+        std::cout << "Error in filename";
+        return PolygonMesh();
+    }
+
+    // Chunks of whole lines, parsed in parallel
+    const char *fileEnd = file.getData() + file.getSize();
+    std::vector<const char *> bounds(1, file.getData());
+    while (bounds.back() < fileEnd) {
+        const char *end = bounds.back() + std::min(CHUNK_SIZE, (size_t)(fileEnd - bounds.back()));
+        const char *lineEnd = static_cast<const char *>(std::memchr(end, '\n', fileEnd - end));
+        bounds.push_back(lineEnd ? lineEnd + 1 : fileEnd);
+    }
+    const int chunkNb = bounds.size() - 1;
+    std::vector<Chunk> chunks(chunkNb);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int id = 0; id < chunkNb; ++id) parseLines(bounds[id], bounds[id + 1], chunks[id]);
+
+    // Place of each chunk in the buffers of the mesh
+    std::vector<size_t> firstPosition(chunkNb + 1, 0), firstTexture(chunkNb + 1, 0),
+        firstNormal(chunkNb + 1, 0), firstFace(chunkNb + 1, 0), firstCorner(chunkNb + 1, 0);
+    for (int id = 0; id < chunkNb; ++id) {
+        firstPosition[id + 1] = firstPosition[id] + chunks[id].positions.size();
+        firstTexture[id + 1] = firstTexture[id] + chunks[id].textureCoordinates.size();
+        firstNormal[id + 1] = firstNormal[id] + chunks[id].normals.size();
+        firstFace[id + 1] = firstFace[id] + chunks[id].faceSizes.size();
+        firstCorner[id + 1] = firstCorner[id] + chunks[id].corners.size() / 3;
+    }
+
+    std::vector<glm::vec3> positions(firstPosition[chunkNb]);
+    std::vector<glm::vec2> textureCoordinates(firstTexture[chunkNb]);
+    std::vector<glm::vec3> normals(firstNormal[chunkNb]);
+    std::vector<unsigned> faceOffsets(firstFace[chunkNb] + 1, 0);
+    std::vector<PolygonMesh::Corner> corners(firstCorner[chunkNb]);
+    bool valid = true;
+#pragma omp parallel for schedule(dynamic, 1) reduction(&& : valid)
+    for (int id = 0; id < chunkNb; ++id) {
+        Chunk &chunk = chunks[id];
+        std::copy(chunk.positions.begin(), chunk.positions.end(),
+                  positions.begin() + firstPosition[id]);
+        std::copy(chunk.textureCoordinates.begin(), chunk.textureCoordinates.end(),
+                  textureCoordinates.begin() + firstTexture[id]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + firstNormal[id]);
+
+        unsigned corner = firstCorner[id];
+        for (unsigned face = 0; face < chunk.faceSizes.size(); ++face) {
+            corner += chunk.faceSizes[face];
+            faceOffsets[firstFace[id] + face + 1] = corner;
+        }
+
+        const size_t firsts[3] = {firstPosition[id], firstTexture[id], firstNormal[id]};
+        const size_t counts[3] = {positions.size(), textureCoordinates.size(), normals.size()};
+        // The relative indices before the start of the file are out of range
+        for (unsigned slot : chunk.relativeSlots) {
+            chunk.corners[slot] += firsts[slot % 3];
+            if (chunk.corners[slot] < 0) chunk.corners[slot] = INT32_MAX;
+        }
+        for (unsigned k = 0; k < chunk.corners.size() / 3; ++k) {
+            unsigned ids[3];
+            for (int attribute = 0; attribute < 3; ++attribute) {
+                const int value = chunk.corners[3 * k + attribute];
+                ids[attribute] = value < 0 ? PolygonMesh::NONE : value;
+                valid = valid && (value < (int64_t)counts[attribute]) &&
+                        (attribute > 0 || value >= 0);
+            }
+            corners[firstCorner[id] + k] = PolygonMesh::Corner{ids[0], ids[1], ids[2]};
+        }
+    }
+    if (!valid) throw std::runtime_error("Error in the obj file format");
+
+    return PolygonMesh(std::move(positions), std::move(textureCoordinates), std::move(normals),
+                       std::move(faceOffsets), std::move(corners));
+}
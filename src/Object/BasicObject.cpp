@@ -0,0 +1,48 @@
+#include "BasicObject.hpp"
+
+void BasicObject::shadeMaterial(const glm::vec3 &intersectPt, const float &footprint,
+                                Inter &inter) const {
+    inter.objAlbedo = this->albedo;
+    inter.objReflexionIndex = this->reflexionIndex;
+
+    if (!definedTexture()) {
+        inter.objColor = this->color;
+        inter.objTransparency = this->transparency;
+    } else {
+        bool onTexture = false;
+        glm::vec4 tmp = this->getTexture()->getColor(intersectPt, footprint, onTexture);
+        if (onTexture) {
+            inter.objColor = glm::vec3(tmp[0], tmp[1], tmp[2]);
+            inter.objTransparency = tmp[3];
+        } else {
+            inter.objColor = this->color;
+            inter.objTransparency = this->transparency;
+        }
+    }
+}
+
+void BasicObject::hitPacket(const RayPacket &packet, PacketHit &hits) const {
+    Ray ray;
+    HitRecord rec;
+    for (unsigned lane = 0; lane < packet.size; ++lane) {
+        ray.setInitPt(glm::vec3(packet.ox[lane], packet.oy[lane], packet.oz[lane]));
+        ray.setDir(glm::vec3(packet.dx[lane], packet.dy[lane], packet.dz[lane]));
+        if (hit(ray, hits.t[lane], rec)) {
+            hits.t[lane] = rec.t;
+            hits.primId[lane] = rec.primId;
+            hits.id[lane] = 0;
+        }
+    }
+}
+
+void BasicObject::intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
+                            std::vector<Ray> &rays) const {
+    HitRecord rec;
+    if (!hit(iRay, INFINITY, rec)) return;
+    shade(iRay, rec, inter);
+
+    glm::vec3 intersectPt = iRay.getInitPt() + rec.t * iRay.getDir();
+    ltSrc->outboundRays(intersectPt, rays);
+    inter.ld = glm::distance(intersectPt, ltSrc->pos);
+    inter.rColor = rays[0].getColor();
+}
@@ -10,11 +10,14 @@
 #include <glm/gtx/norm.hpp>
 #include <glm/vec3.hpp>
 
+#include "AABB.hpp"
 #include "Ray.hpp"
 #include "Texture.hpp"
 #include "BasicObject.hpp"
 #include "Light.hpp"
 #include "Inter.hpp"
+#include "HitRecord.hpp"
+#include "RayPacket.hpp"
 
 //!  The BasicObject class.
 /**
@@ -67,6 +70,16 @@ protected:
      */
     bool hasTexture;
 
+    /**
+     * @brief Fill the material part of the intersection (color, transparency, albedo and
+     * reflexion index), using the texture when the intersection point is on it.
+     *
+     * @param intersectPt the intersection point
+     * @param footprint the width of the area of the surface seen through the pixel
+     * @param inter the data about the intersection
+     */
+    void shadeMaterial(const glm::vec3 &intersectPt, const float &footprint, Inter &inter) const;
+
 public:
     /**
      * @brief Getter to know if the texture is defined.
@@ -94,15 +107,84 @@ public:
     }
 
     /**
-     * @brief Computes the rays generated by the intersection between an object and a ray
+     * @brief Finds the distance of the intersection between the object and a ray, without
+     * computing anything else. This is the query used to look for the closest object.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, modified only if the function returns true
+     * @return true if the object is hit closer than tMax
+     */
+    virtual bool hit(const Ray &iRay, float tMax, HitRecord &rec) const = 0;
+
+    /**
+     * @brief Computes the normal and the material at an intersection found by hit.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
+     * @param inter the data about the intersection
+     */
+    virtual void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const = 0;
+
+    /**
+     * @brief The hit query for a packet of coherent rays. For each ray which hits the object
+     * closer than hits.t[lane], hits.t[lane] is lowered and the id of the hit primitive is stored
+     * in hits.primId[lane] and hits.id[lane]. By default the rays are tested one by one with hit:
+     * objects override it with a vectorized kernel.
+     *
+     * @param packet the incoming rays
+     * @param hits the closest hits of the rays, modified only for the rays hitting the object
+     */
+    virtual void hitPacket(const RayPacket &packet, PacketHit &hits) const;
+
+    /**
+     * @brief Tells whether the object blocks a ray before maxDist. Any intersection is enough,
+     * so objects should override it with a kernel stopping as soon as it is known.
+     *
+     * @param iRay the incoming ray, usually going to a light source
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if the object is hit closer than maxDist
+     */
+    virtual bool occluded(const Ray &iRay, float maxDist) const {
+        HitRecord rec;
+        return hit(iRay, maxDist, rec);
+    }
+
+    /**
+     * @brief Computes the rays generated by the intersection between an object and a ray. It is
+     * hit, then shade and the ray going to the light source.
      *
      * @param iRay the incoming ray
      * @param ltSrc the light source
      * @param inter the data about the intersection
      * @param rays the outgoing rays
      */
-    virtual void intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                           std::vector<Ray> &rays) const = 0;
+    void intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
+                   std::vector<Ray> &rays) const;
+
+    /**
+     * @brief Get the axis-aligned box containing the object, used by the acceleration structure
+     * of the scene.
+     *
+     * @return AABB
+     */
+    virtual AABB getBounds() const = 0;
+
+    /**
+     * @brief Returns false for infinite objects, which are kept out of the acceleration structure.
+     *
+     */
+    virtual bool isBounded() const { return true; }
+
+    /**
+     * @brief Get the object whose material is hit, which is the object itself except for the
+     * groups of objects. The scene stores it in the hit records, so that the shading and the
+     * secondary rays use the material of the primitive hit.
+     *
+     * @param primId the id of the hit primitive, from the hit record
+     * @return const BasicObject*
+     */
+    virtual const BasicObject *getHitObject(unsigned /*primId*/) const { return this; }
 
     /**
      * @brief Construct a new Basic Object object
@@ -1,43 +1,44 @@
 #include "Box.hpp"
 
-// A Compléter - importé et refactoré de scratchapixel, mais manque l'emission des rayons créés
-// (code )
-/*void Box::intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                    std::vector<Ray> &rays) const {
-    float tmin, tmax, tymin, tymax, tzmin, tzmax;
-
-    tmin = (bounds[r.sign[0]].x - r.orig.x) * r.invdir.x;
-    tmax = (bounds[1 - r.sign[0]].x - r.orig.x) * r.invdir.x;
-    tymin = (bounds[r.sign[1]].y - r.orig.y) * r.invdir.y;
-    tymax = (bounds[1 - r.sign[1]].y - r.orig.y) * r.invdir.y;
-
-    if ((tmin > tymax) || (tymin > tmax)) return;
-    if (tymin > tmin) tmin = tymin;
-    if (tymax < tmax) tmax = tymax;
-
-    tzmin = (bounds[r.sign[2]].z - r.orig.z) * r.invdir.z;
-    tzmax = (bounds[1 - r.sign[2]].z - r.orig.z) * r.invdir.z;
-
-    if ((tmin > tzmax) || (tzmin > tmax)) return;
-    if (tzmin > tmin) tmin = tzmin;
-    if (tzmax < tmax) tmax = tzmax;
+#include <glm/gtc/constants.hpp>
+
+bool Box::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    float tEnter = -INFINITY;
+    float tExit = INFINITY;
+    getBounds().clip(iRay, tEnter, tExit);
+    // the entry point, or the exit point for a ray starting inside, as for a Sphere
+    float t = tEnter > glm::epsilon<float>() ? tEnter : tExit;
+    if (!(tEnter <= tExit) || !(t > glm::epsilon<float>()) || t >= tMax) return false;
+    rec.t = t;
+    rec.primId = 0;
+    return true;
+}
 
-    t = tmin;
-    if (t < 0) {
-        t = tmax;
-        if (t < 0) return;
+void Box::shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const {
+    glm::vec3 intersectPt = iRay.getInitPt() + rec.t * iRay.getDir();
+    inter.id = rec.t;
+    // The face hit is the one along which the point is the furthest from the center, relatively
+    // to the half size of the box
+    const AABB bounds = getBounds();
+    const glm::vec3 halfSize = bounds.extent() * 0.5f;
+    const glm::vec3 offset = intersectPt - bounds.centroid();
+    int axis = 0;
+    float furthest = -1;
+    for (int k = 0; k < 3; ++k) {
+        const float distance = halfSize[k] > 0 ? std::abs(offset[k]) / halfSize[k] : 1;
+        if (distance > furthest) {
+            furthest = distance;
+            axis = k;
+        }
     }
-    inter.objColor = this->color;
-    inter.objAlbedo = this->albedo;
-    inter.objReflexionIndex = this->reflexionIndex;
-    inter.objTransparency = this->transparency;
-}*/
+    inter.normal = glm::vec3(0, 0, 0);
+    inter.normal[axis] = offset[axis] < 0 ? -1 : 1;
+    shadeMaterial(intersectPt, iRay.getFootprint(rec.t, inter.normal), inter);
+}
 
 std::ostream &Box::printInfo(std::ostream &os) const {
     return os << "  - Box -" << std::endl
-              << "v0: " << pos << std::endl
-              << "v1: " << pos1 << std::endl
-              << "v2: " << pos2 << std::endl
-              << "v3: " << pos3;
+              << "at: " << pos << std::endl
+              << "size: " << size << std::endl
+              << "albedo: " << albedo;
 }
-
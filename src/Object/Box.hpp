@@ -10,36 +10,73 @@
 #include <glm/gtx/norm.hpp>
 #include <glm/vec3.hpp>
 
+#include "AABB.hpp"
 #include "Ray.hpp"
 #include "Texture.hpp"
 #include "BasicObject.hpp"
 
+//!  The Box class.
+/**
+    \class Box
+  @brief It represents a solid box whose faces are aligned with the axes, intersected with the
+  same slab test as the nodes of the BVH.
+*/
 class Box : public BasicObject {
 public:
-    glm::vec3 pos1;
-    glm::vec3 pos2;
-    glm::vec3 pos3;
+    //! A public variable.
+    /**
+      @brief The size of the box along each axis, from the corner pos. A negative size puts the
+      box on the other side of pos.
+    */
+    glm::vec3 size;
 
-    void intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                   std::vector<Ray> &rays) const override;
+    /**
+     * @brief Finds the distance of the intersection between the box and a ray: the distance at
+     * which the ray enters the box, or leaves it if the ray starts inside.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, modified only if there is a hit
+     * @return true if the box is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const override;
+
+    /**
+     * @brief Computes the normal and the material at an intersection found by hit. The normal is
+     * the one of the face closest to the intersection.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
+     * @param inter the intersection object which contains the intersection information
+     */
+    void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const override;
+
+    /**
+     * @brief Get the box itself
+     *
+     * @return AABB
+     */
+    AABB getBounds() const override {
+        AABB bounds(pos, pos);
+        bounds.expand(pos + size);
+        return bounds;
+    }
 
     /**
-     * @brief Construct a new Box object
+     * @brief Construct a Box of size 1 at (0, 0, 0) by default.
      *
-     * @param v0
-     * @param v1
-     * @param v2
-     * @param v3
-     * @param color
-     * @param t
-     * @param r
-     * @param R
-     * @param a
+     * @param pos the coordinates of a corner of the box
+     * @param size the size of the box along each axis, from pos
+     * @param color the color of the box
+     * @param t the transparency of the box
+     * @param r the reflexion index of the box
+     * @param R the refraction index of the box
+     * @param a the albedo of the box
      */
-    explicit Box(glm::vec3 v0 = glm::vec3(), glm::vec3 v1 = glm::vec3(), glm::vec3 v2 = glm::vec3(),
-                 glm::vec3 v3 = glm::vec3(), glm::vec3 color = glm::vec3(1, 1, 1), float t = 0,
-                 float r = 1, float R = 1, float a = 0.18)
-        : BasicObject(pos, color, t, r, R, a), pos1(pos1), pos2(pos2), pos3(pos3) {}
+    explicit Box(glm::vec3 pos = glm::vec3(), glm::vec3 size = glm::vec3(1, 1, 1),
+                 glm::vec3 color = glm::vec3(1, 1, 1), float t = 0, float r = 0, float R = 0,
+                 float a = 0.18)
+        : BasicObject(pos, color, t, r, R, a), size(size) {}
 
 protected:
     //! @brief A normal member taking one argument and returning the information about
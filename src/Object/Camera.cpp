@@ -1,11 +1,14 @@
 #include "Camera.hpp"
 
-Ray Camera::genRay(const float &x, const float &y) {
+Ray Camera::genRay(const float &x, const float &y) const {
     if (x > resX || y > resY || x < 0 || y < 0) throw Camera::pixel_out_of_range();
 
     glm::vec3 rDir = dir * focalLength + hv * (float)(y / resY - 0.5) * sizeY +
                      vv * (float)(x / resX - 0.5) * sizeX;
-    return Ray(pos, rDir);
+    // The beam covers a pixel of the screen, at the length of rDir from the camera
+    Ray ray(pos, rDir);
+    ray.setBeam(0, sizeX / resX / glm::length(rDir));
+    return ray;
 }
 
 std::ostream &Camera::printInfo(std::ostream &os) const {
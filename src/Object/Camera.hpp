@@ -77,13 +77,14 @@ public:
     int getNumberOfPixels() const { return resX * resY; }
     
     /**
-     * @brief A normal member taking two arguments and returning the generated ray
+     * @brief A normal member taking two arguments and returning the generated ray, whose beam
+     * covers a pixel
      *
      * @param x the number of the x pixel
      * @param y the number of the y pixel
      * @return Ray
      */
-    Ray genRay(const float &x, const float &y);
+    Ray genRay(const float &x, const float &y) const;
 
     /**
      * @brief Construct a Camera at (0, 0, 0) with screen of size (1, 1) and (1000, 1000)
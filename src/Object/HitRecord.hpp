@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cmath>
+
+class BasicObject;
+
+/**
+ * @class HitRecord
+ * @brief The minimal result of a ray query: where the closest hit is and what was hit. The
+ * shading data (normal, colors, light rays) is only computed afterwards for the winning hit.
+ * @sa Inter
+ *
+ */
+class HitRecord {
+public:
+    //! A public variable.
+    /**
+     * @brief The distance between the origin of the ray and the intersection.
+     *
+     */
+    float t;
+
+    //! A public variable.
+    /**
+     * @brief The id of the hit primitive inside the object (the triangle of a mesh for
+     * instance), 0 for simple objects.
+     *
+     */
+    unsigned primId;
+
+    //! A public variable.
+    /**
+     * @brief The object of the scene which has been hit, set by the scene.
+     *
+     */
+    const BasicObject *object;
+
+    //! The default constructor.
+    /**
+     * @brief Construct an empty record, which is further than any hit.
+     *
+     */
+    HitRecord() : t(INFINITY), primId(0), object(nullptr) {}
+};
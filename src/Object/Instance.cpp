@@ -0,0 +1,74 @@
+#include "Instance.hpp"
+
+#include <glm/matrix.hpp>
+
+Instance::Instance(const std::shared_ptr<const TriangleMesh> &mesh, const glm::mat4 &transform,
+                   glm::vec3 color, float t, float r, float R, float a)
+    : BasicObject(glm::vec3(transform[3]), color, t, r, R, a),
+      mesh(mesh),
+      toWorld(transform),
+      toObject(glm::inverse(transform)),
+      normalToWorld(glm::transpose(glm::inverse(glm::mat3(transform)))) {}
+
+Ray Instance::toObjectSpace(const Ray &iRay) const {
+    Ray ray;
+    ray.setInitPt(glm::vec3(toObject * glm::vec4(iRay.getInitPt(), 1)));
+    ray.setDir(glm::mat3(toObject) * iRay.getDir());
+    return ray;
+}
+
+bool Instance::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    return mesh->hit(toObjectSpace(iRay), tMax, rec);
+}
+
+void Instance::hitPacket(const RayPacket &packet, PacketHit &hits) const {
+    const glm::mat3 linear(toObject);
+    const glm::vec3 translation(toObject[3]);
+    RayPacket local;
+    local.size = packet.size;
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        const glm::vec3 origin =
+            linear * glm::vec3(packet.ox[lane], packet.oy[lane], packet.oz[lane]) + translation;
+        const glm::vec3 dir = linear * glm::vec3(packet.dx[lane], packet.dy[lane], packet.dz[lane]);
+        local.ox[lane] = origin.x;
+        local.oy[lane] = origin.y;
+        local.oz[lane] = origin.z;
+        local.dx[lane] = dir.x;
+        local.dy[lane] = dir.y;
+        local.dz[lane] = dir.z;
+        local.invDx[lane] = 1.0f / dir.x;
+        local.invDy[lane] = 1.0f / dir.y;
+        local.invDz[lane] = 1.0f / dir.z;
+    }
+    mesh->hitPacket(local, hits);
+}
+
+bool Instance::occluded(const Ray &iRay, float maxDist) const {
+    return mesh->occluded(toObjectSpace(iRay), maxDist);
+}
+
+void Instance::shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const {
+    glm::vec3 intersectPt = iRay.getInitPt() + rec.t * iRay.getDir();
+    inter.id = rec.t;
+    inter.normal = glm::normalize(normalToWorld * mesh->getNormal(rec.primId));
+    shadeMaterial(intersectPt, iRay.getFootprint(rec.t, inter.normal), inter);
+}
+
+AABB Instance::getBounds() const {
+    const AABB meshBounds = mesh->getBounds();
+    AABB bounds;
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec3 pt(corner & 1 ? meshBounds.max.x : meshBounds.min.x,
+                           corner & 2 ? meshBounds.max.y : meshBounds.min.y,
+                           corner & 4 ? meshBounds.max.z : meshBounds.min.z);
+        bounds.expand(glm::vec3(toWorld * glm::vec4(pt, 1)));
+    }
+    return bounds;
+}
+
+std::ostream &Instance::printInfo(std::ostream &os) const {
+    return os << "  - Instance -" << std::endl
+              << "at: " << pos << std::endl
+              << "triangles: " << mesh->getNumberOfTriangles() << std::endl
+              << "albedo: " << albedo;
+}
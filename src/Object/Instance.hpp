@@ -0,0 +1,140 @@
+#pragma once
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <iostream>
+#include <memory>
+
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include "Ray.hpp"
+#include "RayPacket.hpp"
+#include "BasicObject.hpp"
+#include "TriangleMesh.hpp"
+
+//!  The Instance class.
+/**
+    \class Instance
+  @brief A copy of a triangle mesh placed in the scene by a transform. The triangles and the BVH
+  of the mesh are shared by all its instances: the rays are brought into the space of the mesh
+  instead, so that a mesh repeated many times is only stored once. The material is the one of the
+  instance, not the one of the mesh.
+*/
+class Instance : public BasicObject {
+protected:
+    /**
+     * @brief The shared geometry.
+     *
+     */
+    std::shared_ptr<const TriangleMesh> mesh;
+
+    /**
+     * @brief The transform from the space of the mesh to the scene.
+     *
+     */
+    glm::mat4 toWorld;
+
+    /**
+     * @brief The transform from the scene to the space of the mesh.
+     *
+     */
+    glm::mat4 toObject;
+
+    /**
+     * @brief The transform of the normals to the scene, the inverse transpose of toWorld.
+     *
+     */
+    glm::mat3 normalToWorld;
+
+    /**
+     * @brief Bring a ray into the space of the mesh. Its direction is not normalized, so that the
+     * distances along the ray are the same in both spaces.
+     *
+     * @param iRay the ray in the scene
+     * @return Ray
+     */
+    Ray toObjectSpace(const Ray &iRay) const;
+
+public:
+    /**
+     * @brief Finds the closest triangle of the mesh hit by a ray.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, whose primId is the id of the hit triangle
+     * @return true if a triangle is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const override;
+
+    /**
+     * @brief The hit query for a packet of rays, brought together into the space of the mesh.
+     *
+     * @param packet the incoming rays
+     * @param hits the closest hits of the rays
+     */
+    void hitPacket(const RayPacket &packet, PacketHit &hits) const override;
+
+    /**
+     * @brief Tells whether a triangle of the mesh blocks a ray before maxDist.
+     *
+     * @param iRay the incoming ray
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if a triangle is hit closer than maxDist
+     */
+    bool occluded(const Ray &iRay, float maxDist) const override;
+
+    /**
+     * @brief Computes the normal, brought back into the scene, and the material of the instance.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
+     * @param inter the data about the intersection
+     */
+    void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const override;
+
+    /**
+     * @brief Get the box containing the transformed box of the mesh
+     *
+     * @return AABB
+     */
+    AABB getBounds() const override;
+
+    /**
+     * @brief Get the Mesh object
+     *
+     * @return std::shared_ptr<const TriangleMesh>
+     */
+    std::shared_ptr<const TriangleMesh> getMesh() const { return this->mesh; }
+
+    /**
+     * @brief Get the transform from the space of the mesh to the scene
+     *
+     * @return const glm::mat4&
+     */
+    const glm::mat4 &getTransform() const { return this->toWorld; }
+
+    /**
+     * @brief Construct a new Instance of a mesh.
+     *
+     * @param mesh the shared mesh
+     * @param transform the transform from the space of the mesh to the scene, invertible
+     * @param color the color of the instance
+     * @param t the transparency of the instance
+     * @param r the refraction index of the instance
+     * @param R the reflexion index of the instance
+     * @param a the albedo of the instance
+     */
+    Instance(const std::shared_ptr<const TriangleMesh> &mesh, const glm::mat4 &transform,
+             glm::vec3 color = glm::vec3(1, 1, 1), float t = 0, float r = 0, float R = 0,
+             float a = 0.18);
+
+protected:
+    //! @brief A normal member taking one argument and returning the information about
+    //! an object. It replaces the pure virtual member of PhysicalObject
+    /**
+      @param os the current ostream
+      @return The information of the object as an ostream
+    */
+    std::ostream &printInfo(std::ostream &os) const override;
+};
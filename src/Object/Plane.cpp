@@ -1,38 +1,45 @@
 #include "Plane.hpp"
 
-void Plane::intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                      std::vector<Ray> &rays) const {
-    // true if there is an intersection, false if there is none
-    bool intersect = glm::intersectRayPlane(iRay.getInitPt(), iRay.getDir(), pos, normal, inter.id);
-    if (intersect) {
-        glm::vec3 intersectPt = iRay.getInitPt() + inter.id * iRay.getDir();
-        inter.normal = normal;
-
-        ltSrc->outboundRays(intersectPt, rays);
+#include <glm/gtc/constants.hpp>
 
-        inter.ld = glm::distance(intersectPt, ltSrc->pos);
-        inter.rColor = rays[0].getColor();
+bool Plane::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    float t;
+    // true if there is an intersection, false if there is none
+    if (!glm::intersectRayPlane(iRay.getInitPt(), iRay.getDir(), pos, normal, t) || t >= tMax)
+        return false;
+    rec.t = t;
+    rec.primId = 0;
+    return true;
+}
 
-        inter.objAlbedo = this->albedo;
-        inter.objReflexionIndex = this->reflexionIndex;
+void Plane::shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const {
+    glm::vec3 intersectPt = iRay.getInitPt() + rec.t * iRay.getDir();
+    inter.id = rec.t;
+    inter.normal = normal;
+    shadeMaterial(intersectPt, iRay.getFootprint(rec.t, inter.normal), inter);
+}
 
-        if (!definedTexture()) {
-            inter.objColor = this->color;
-            inter.objTransparency = this->transparency;
-        } else {
-            bool onTexture = false;
-            glm::vec4 tmp = this->getTexture()->getColor(intersectPt, onTexture);
-            if (onTexture) {
-                inter.objColor = glm::vec3(tmp[0], tmp[1], tmp[2]);
-                inter.objTransparency = tmp[3];
-            } else {
-                inter.objColor = this->color;
-                inter.objTransparency = this->transparency;
-            }
-        }
+void Plane::hitPacket(const RayPacket &packet, PacketHit &hits) const {
+    // same test as glm::intersectRayPlane
+#pragma omp simd
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        float d = packet.dx[lane] * normal.x + packet.dy[lane] * normal.y +
+                  packet.dz[lane] * normal.z;
+        float t = ((pos.x - packet.ox[lane]) * normal.x + (pos.y - packet.oy[lane]) * normal.y +
+                   (pos.z - packet.oz[lane]) * normal.z) /
+                  d;
+        bool closer = std::fabs(d) > glm::epsilon<float>() && t > 0 && t < hits.t[lane];
+        hits.t[lane] = closer ? t : hits.t[lane];
+        hits.primId[lane] = closer ? 0 : hits.primId[lane];
+        hits.id[lane] = closer ? 0 : hits.id[lane];
     }
 }
 
+bool Plane::occluded(const Ray &iRay, float maxDist) const {
+    float t;
+    return glm::intersectRayPlane(iRay.getInitPt(), iRay.getDir(), pos, normal, t) && t < maxDist;
+}
+
 std::ostream &Plane::printInfo(std::ostream &os) const {
     return os << "   - Plan -" << std::endl
               << "at: " << pos << std::endl
@@ -28,8 +28,53 @@ public:
     glm::vec3 normal;
 
 public:
-    void intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                   std::vector<Ray> &rays) const override;
+    /**
+     * @brief Finds the distance of the intersection between the plane and a ray.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, modified only if there is a hit
+     * @return true if the plane is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const override;
+
+    /**
+     * @brief Computes the normal and the material at an intersection found by hit.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
+     * @param inter the intersection object which contains the intersection information
+     */
+    void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const override;
+
+    /**
+     * @brief Vectorized hit query of a packet of rays against the plane.
+     *
+     * @param packet the incoming rays
+     * @param hits the closest hits of the rays, lowered for the rays hitting the plane
+     */
+    void hitPacket(const RayPacket &packet, PacketHit &hits) const override;
+
+    /**
+     * @brief Tells whether the plane blocks a ray before maxDist.
+     *
+     * @param iRay the incoming ray
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if the plane is hit closer than maxDist
+     */
+    bool occluded(const Ray &iRay, float maxDist) const override;
+
+    /**
+     * @brief A plane is infinite: its box is the whole space.
+     *
+     * @return AABB
+     */
+    AABB getBounds() const override {
+        return AABB(glm::vec3(-INFINITY, -INFINITY, -INFINITY),
+                    glm::vec3(INFINITY, INFINITY, INFINITY));
+    }
+
+    bool isBounded() const override { return false; }
 
     /**
      * @brief Construct a Plan of normal (0, 0, 1) and containing (0, 0, 0) by default.
@@ -1,11 +1,39 @@
 #include "PolygonMesh.hpp"
 
+Polygon PolygonMesh::getPolygon(unsigned id) const {
+    Polygon poly;
+    for (unsigned corner = faceOffsets[id]; corner < faceOffsets[id + 1]; ++corner) {
+        poly.addVertex(positions[corners[corner].position]);
+        if (corners[corner].texture != NONE)
+            poly.addTexture(textureCoordinates[corners[corner].texture]);
+    }
+    const unsigned normal = faceOffsets[id] < faceOffsets[id + 1]
+                                ? corners[faceOffsets[id]].normal
+                                : NONE;
+    poly.setNormal(normal != NONE ? normals[normal] : glm::vec3(1, 1, 1));
+    return poly;
+}
+
+void PolygonMesh::addPolygon(const Polygon &poly) {
+    const unsigned normal = normals.size();
+    normals.push_back(poly.normal);
+    for (unsigned k = 0; k < poly.vertices.size(); ++k) {
+        unsigned texture = NONE;
+        if (k < poly.textureCoordinates.size()) {
+            texture = textureCoordinates.size();
+            textureCoordinates.push_back(poly.textureCoordinates[k]);
+        }
+        corners.push_back(Corner{(unsigned)positions.size(), texture, normal});
+        positions.push_back(poly.vertices[k]);
+    }
+    faceOffsets.push_back(corners.size());
+}
+
 std::ostream &PolygonMesh::printInfo(std::ostream &os) const {
-    std::string stream;
     os << "  - PolygonMesh - \n"
-       << "Number of triangles: " << std::to_string(polygons.size()) << '\n';
-    for (Polygon poly : polygons) {
-        os << poly << std::endl;
+       << "Number of polygons: " << std::to_string(getPolygonCount()) << '\n';
+    for (unsigned id = 0; id < getPolygonCount(); ++id) {
+        os << getPolygon(id) << std::endl;
     }
-    return os << stream;
+    return os;
 }
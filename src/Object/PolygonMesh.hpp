@@ -3,11 +3,13 @@
 
 #include <iostream>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <glm/geometric.hpp>
 #include <glm/gtx/intersect.hpp>
 #include <glm/gtx/norm.hpp>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
 #include "Ray.hpp"
@@ -15,35 +17,131 @@
 #include "PhysicalObject.hpp"
 #include "Polygon.hpp"
 
+/**
+ * @class PolygonMesh
+ * @brief A mesh of polygons stored as indexed buffers: the positions, texture coordinates and
+ * normals are stored once, and each corner of a face refers to them by their index, as in the OBJ
+ * files.
+ *
+ */
 class PolygonMesh : public PhysicalObject {
+public:
+    /**
+     * @brief The index of a missing texture coordinate or normal.
+     *
+     */
+    static constexpr unsigned NONE = 0xFFFFFFFF;
+
+    /**
+     * @brief A corner of a face: the indices of its position, texture coordinates and normal.
+     *
+     */
+    struct Corner {
+        unsigned position;
+        unsigned texture;
+        unsigned normal;
+    };
+
 protected:
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> textureCoordinates;
+    std::vector<glm::vec3> normals;
+
     /**
-     * @brief
+     * @brief The index of the first corner of each face, followed by the number of corners.
      *
      */
-    std::vector<Polygon> polygons;
+    std::vector<unsigned> faceOffsets;
+
+    /**
+     * @brief The corners of the faces, face after face.
+     *
+     */
+    std::vector<Corner> corners;
 
 public:
     /**
-     * @brief
+     * @brief Get the Positions object
+     *
+     * @return const std::vector<glm::vec3>&
+     */
+    const std::vector<glm::vec3> &getPositions() const { return positions; }
+
+    /**
+     * @brief Get the Texture Coordinates object
+     *
+     * @return const std::vector<glm::vec2>&
+     */
+    const std::vector<glm::vec2> &getTextureCoordinates() const { return textureCoordinates; }
+
+    /**
+     * @brief Get the Normals object
+     *
+     * @return const std::vector<glm::vec3>&
+     */
+    const std::vector<glm::vec3> &getNormals() const { return normals; }
+
+    /**
+     * @brief Get the Face Offsets object
      *
-     * @return std::vector<Polygon>::iterator
+     * @return const std::vector<unsigned>& the first corner of each face, then the number of
+     * corners
      */
-    std::vector<Polygon>::iterator begin() { return polygons.begin(); }
+    const std::vector<unsigned> &getFaceOffsets() const { return faceOffsets; }
 
     /**
-     * @brief
+     * @brief Get the Corners object
      *
-     * @return std::vector<Polygon>::iterator
+     * @return const std::vector<Corner>&
      */
-    std::vector<Polygon>::iterator end() { return polygons.end(); }
+    const std::vector<Corner> &getCorners() const { return corners; }
 
     /**
-     * @brief
+     * @brief Get the number of polygons
+     *
+     * @return unsigned
+     */
+    unsigned getPolygonCount() const { return faceOffsets.size() - 1; }
+
+    /**
+     * @brief Build a polygon of the mesh, whose normal is the normal of its first corner, or
+     * (1, 1, 1) if it has none so that it is computed from the vertices
+     *
+     * @param id the index of the polygon
+     * @return Polygon
+     */
+    Polygon getPolygon(unsigned id) const;
+
+    /**
+     * @brief Add a polygon to the mesh, all its corners having its normal
      *
      * @param poly
      */
-    void addPolygon(const Polygon &poly) { polygons.push_back(poly); }
+    void addPolygon(const Polygon &poly);
+
+    /**
+     * @brief Construct an empty Polygon Mesh object
+     *
+     */
+    PolygonMesh() : faceOffsets(1, 0) {}
+
+    /**
+     * @brief Construct a new Polygon Mesh object from its buffers, which are moved into the mesh
+     *
+     * @param pos the positions
+     * @param tex the texture coordinates
+     * @param norm the normals
+     * @param offsets the first corner of each face, followed by the number of corners
+     * @param faceCorners the corners of the faces
+     */
+    explicit PolygonMesh(std::vector<glm::vec3> pos, std::vector<glm::vec2> tex,
+                         std::vector<glm::vec3> norm, std::vector<unsigned> offsets,
+                         std::vector<Corner> faceCorners)
+        : positions(std::move(pos)),
+          textureCoordinates(std::move(tex)),
+          normals(std::move(norm)),
+          faceOffsets(std::move(offsets)),
+          corners(std::move(faceCorners)) {}
 
 protected:
     //! @brief A normal member taking one argument and returning the information about
@@ -1,41 +1,63 @@
 #include "Sphere.hpp"
 
-void Sphere::intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                       std::vector<Ray> &rays) const {
-    glm::vec3 intersectPt;
-    bool intersect = glm::intersectRaySphere(iRay.getInitPt(), iRay.getDir(), pos, radius,
-                                             intersectPt, inter.normal);
-    if (intersect) {
-        inter.id = glm::distance(iRay.getInitPt(), intersectPt);
+#include <glm/gtc/constants.hpp>
 
-        ltSrc->outboundRays(intersectPt, rays);
-        inter.ld = glm::distance(intersectPt, ltSrc->pos);
-        inter.rColor = rays[0].getColor();
+bool Sphere::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    float t;
+    if (!glm::intersectRaySphere(iRay.getInitPt(), iRay.getDir(), pos, radius * radius, t) ||
+        t >= tMax)
+        return false;
+    rec.t = t;
+    rec.primId = 0;
+    return true;
+}
 
-        inter.objReflexionIndex = this->reflexionIndex;
-        inter.objAlbedo = this->albedo;
+void Sphere::shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const {
+    glm::vec3 intersectPt = iRay.getInitPt() + rec.t * iRay.getDir();
+    inter.id = rec.t;
+    inter.normal = (intersectPt - pos) / radius;
+    shadeMaterial(intersectPt, iRay.getFootprint(rec.t, inter.normal), inter);
+}
 
-        if (!definedTexture()) {
-            inter.objColor = this->color;
-            inter.objTransparency = this->transparency;
-        } else {
-            bool onTexture = false;
-            glm::vec4 tmp = this->getTexture()->getColor(intersectPt, onTexture);
-            if (onTexture) {
-                inter.objColor = glm::vec3(tmp[0], tmp[1], tmp[2]);
-                inter.objTransparency = tmp[3];
-            } else {
-                inter.objColor = this->color;
-                inter.objTransparency = this->transparency;
-            }
-        }
+void Sphere::hitPacket(const RayPacket &packet, PacketHit &hits) const {
+    const float radius2 = radius * radius;
+    const float epsilon = glm::epsilon<float>();
+    // same distance as glm::intersectRaySphere
+#pragma omp simd
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        float diffX = pos.x - packet.ox[lane];
+        float diffY = pos.y - packet.oy[lane];
+        float diffZ = pos.z - packet.oz[lane];
+        float tca = diffX * packet.dx[lane] + diffY * packet.dy[lane] + diffZ * packet.dz[lane];
+        float d2 = diffX * diffX + diffY * diffY + diffZ * diffZ - tca * tca;
+        float thc = sqrtf(std::max(0.f, radius2 - d2));
+        float t = tca > thc + epsilon ? tca - thc : tca + thc;
+        bool closer = !(d2 > radius2) && t > epsilon && t < hits.t[lane];
+        hits.t[lane] = closer ? t : hits.t[lane];
+        hits.primId[lane] = closer ? 0 : hits.primId[lane];
+        hits.id[lane] = closer ? 0 : hits.id[lane];
     }
 }
 
+bool Sphere::occluded(const Ray &iRay, float maxDist) const {
+    glm::vec3 diff = pos - iRay.getInitPt();
+    float radius2 = radius * radius;
+    float diff2 = glm::dot(diff, diff);
+    float tca = glm::dot(diff, iRay.getDir());
+    // origin outside the sphere, which is behind it or too far away: no need for a square root
+    if (diff2 > radius2 && (tca < 0 || tca - radius >= maxDist)) return false;
+
+    // same distance as glm::intersectRaySphere
+    float d2 = diff2 - tca * tca;
+    if (d2 > radius2) return false;
+    float thc = sqrtf(radius2 - d2);
+    float t = tca > thc + glm::epsilon<float>() ? tca - thc : tca + thc;
+    return t > glm::epsilon<float>() && t < maxDist;
+}
+
 std::ostream &Sphere::printInfo(std::ostream &os) const {
     return os << "  - Sphere -" << std::endl
               << "at: " << pos << std::endl
               << "radius: " << radius << std::endl
               << "albedo: " << albedo;
 }
-
@@ -28,16 +28,50 @@ public:
     float radius;
 
     /**
-     * @brief Computes the intersection between a Ray and a Sphere.
+     * @brief Finds the distance of the intersection between the sphere and a ray.
      *
-     * @param iRay the incoming Ray
-     * @param ltSrc the light source of the scene
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, modified only if there is a hit
+     * @return true if the sphere is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const override;
+
+    /**
+     * @brief Computes the normal and the material at an intersection found by hit.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
      * @param inter the intersection object which contains the intersection information
-     * @sa Inter
-     * @param rays The rays created by the intersection
      */
-    void intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                   std::vector<Ray> &rays) const override;
+    void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const override;
+
+    /**
+     * @brief Vectorized hit query of a packet of rays against the sphere.
+     *
+     * @param packet the incoming rays
+     * @param hits the closest hits of the rays, lowered for the rays hitting the sphere
+     */
+    void hitPacket(const RayPacket &packet, PacketHit &hits) const override;
+
+    /**
+     * @brief Tells whether the sphere blocks a ray before maxDist.
+     *
+     * @param iRay the incoming ray
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if the sphere is hit closer than maxDist
+     */
+    bool occluded(const Ray &iRay, float maxDist) const override;
+
+    /**
+     * @brief Get the box containing the sphere
+     *
+     * @return AABB
+     */
+    AABB getBounds() const override {
+        glm::vec3 halfSize(radius, radius, radius);
+        return AABB(pos - halfSize, pos + halfSize);
+    }
 
     /**
      * @brief Construct a Sphere at (0, 0, 0) of radius 1 by default.
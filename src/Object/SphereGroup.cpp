@@ -0,0 +1,177 @@
+#include "SphereGroup.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief The largest number of spheres in a leaf when the surface area heuristic does not keep
+ * more: half a SIMD register of floats at most, since smaller leaves cull more spheres.
+ *
+ */
+constexpr unsigned LEAF_SIZE = std::min(8u, RayPacket::WIDTH);
+
+/**
+ * @brief The distance of the closest intersection in front of a ray with a sphere. The roots of
+ * the quadratic are computed in the numerically stable way: the discriminant from the distance
+ * between the center and the line of the ray, and the smaller root from the product of the roots.
+ *
+ * @param fX the vector from the origin of the ray to the center of the sphere, along x
+ * @param fY along y
+ * @param fZ along z
+ * @param dX the normalized direction of the ray, along x
+ * @param dY along y
+ * @param dZ along z
+ * @param r2 the squared radius of the sphere
+ * @return float INFINITY if the ray misses the sphere
+ */
+inline float sphereDistance(float fX, float fY, float fZ, float dX, float dY, float dZ,
+                            float r2) {
+    // b is the projection of f on the ray and l its distance to the line
+    float b = fX * dX + fY * dY + fZ * dZ;
+    float lX = fX - b * dX;
+    float lY = fY - b * dY;
+    float lZ = fZ - b * dZ;
+    float discriminant = r2 - (lX * lX + lY * lY + lZ * lZ);
+
+    // q is the root away from 0 and c / q the other one, c being their product
+    float c = fX * fX + fY * fY + fZ * fZ - r2;
+    float q = b + std::copysign(std::sqrt(std::max(discriminant, 0.0f)), b);
+    float tNear = std::min(q, c / q);
+    float tFar = std::max(q, c / q);
+    // the closest root in front of the origin, as for a Sphere
+    const float epsilon = std::numeric_limits<float>::epsilon();
+    float dist = tNear > epsilon ? tNear : tFar;
+    return discriminant >= 0 && dist > epsilon ? dist : INFINITY;
+}
+
+}  // namespace
+
+SphereGroup::SphereGroup(const std::vector<std::shared_ptr<Sphere>> &spheres)
+    : bvh(LEAF_SIZE) {
+    if (spheres.empty()) throw std::runtime_error("A sphere group holds at least one sphere");
+    pos = spheres[0]->pos;
+
+    std::vector<AABB> sphereBounds(spheres.size());
+    for (unsigned id = 0; id < spheres.size(); ++id) sphereBounds[id] = spheres[id]->getBounds();
+    bvh.build(sphereBounds);
+
+    // Store the spheres in the order of the leaves
+    std::vector<unsigned> order;
+    bvh.renumberPrimitives(order);
+    for (int axis = 0; axis < 3; ++axis) center[axis].resize(spheres.size());
+    radius2.resize(spheres.size());
+    for (unsigned id = 0; id < spheres.size(); ++id) {
+        const Sphere &sphere = *spheres[order[id]];
+        this->spheres.push_back(spheres[order[id]]);
+        addedIds.push_back(order[id]);
+        for (int axis = 0; axis < 3; ++axis) center[axis][id] = sphere.pos[axis];
+        radius2[id] = sphere.radius * sphere.radius;
+    }
+}
+
+void SphereGroup::intersectSpheres(const Ray &iRay, unsigned first, unsigned count,
+                                   float *t) const {
+    const glm::vec3 origin = iRay.getInitPt();
+    const glm::vec3 dir = iRay.getDir();
+    const float *cx = &center[0][first], *cy = &center[1][first], *cz = &center[2][first];
+    const float *r2 = &radius2[first];
+#pragma omp simd
+    for (unsigned k = 0; k < count; ++k) {
+        t[k] = sphereDistance(cx[k] - origin.x, cy[k] - origin.y, cz[k] - origin.z, dir.x, dir.y,
+                              dir.z, r2[k]);
+    }
+}
+
+void SphereGroup::intersectPacket(const RayPacket &packet, unsigned id, float *t) const {
+    const float cx = center[0][id], cy = center[1][id], cz = center[2][id];
+    const float r2 = radius2[id];
+#pragma omp simd
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        t[lane] = sphereDistance(cx - packet.ox[lane], cy - packet.oy[lane], cz - packet.oz[lane],
+                                 packet.dx[lane], packet.dy[lane], packet.dz[lane], r2);
+    }
+}
+
+bool SphereGroup::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    float minDistance = tMax;
+    unsigned closestId = spheres.size();
+    alignas(64) float t[RayPacket::WIDTH];
+    bvh.traverseLeaves(iRay, minDistance, [&](unsigned first, unsigned count, float &tClosest) {
+        for (unsigned chunk = first; chunk < first + count; chunk += RayPacket::WIDTH) {
+            unsigned chunkSize = std::min<unsigned>(RayPacket::WIDTH, first + count - chunk);
+            intersectSpheres(iRay, chunk, chunkSize, t);
+            for (unsigned k = 0; k < chunkSize; ++k) {
+                if (t[k] < tClosest || (t[k] == tClosest && closestId < spheres.size() &&
+                                        addedIds[chunk + k] < addedIds[closestId])) {
+                    tClosest = t[k];
+                    closestId = chunk + k;
+                }
+            }
+        }
+    });
+
+    if (closestId == spheres.size()) return false;
+    rec.t = minDistance;
+    rec.primId = closestId;
+    return true;
+}
+
+void SphereGroup::hitPacket(const RayPacket &packet, PacketHit &hits) const {
+    // The closest sphere of each ray, the first sphere of the scene winning the ties as in hit
+    PacketHit closest;
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        closest.t[lane] = hits.t[lane];
+        closest.id[lane] = PacketHit::noHit;
+    }
+
+    alignas(64) float t[RayPacket::WIDTH];
+    bvh.traversePacket(packet, closest.t, [&](unsigned id) {
+        intersectPacket(packet, id, t);
+#pragma omp simd
+        for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+            bool found = closest.id[lane] != PacketHit::noHit;
+            bool closer = t[lane] < closest.t[lane] ||
+                          (t[lane] == closest.t[lane] && found &&
+                           addedIds[id] < addedIds[found ? closest.id[lane] : id]);
+            closest.t[lane] = closer ? t[lane] : closest.t[lane];
+            closest.id[lane] = closer ? id : closest.id[lane];
+        }
+    });
+
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        if (closest.id[lane] == PacketHit::noHit) continue;
+        hits.t[lane] = closest.t[lane];
+        hits.primId[lane] = closest.id[lane];
+        hits.id[lane] = closest.id[lane];
+    }
+}
+
+bool SphereGroup::occluded(const Ray &iRay, float maxDist) const {
+    // The spheres of a leaf are tested together, and the walk stops at the first blocking leaf
+    float tMax = maxDist;
+    bool blocked = false;
+    alignas(64) float t[RayPacket::WIDTH];
+    bvh.traverseLeaves(iRay, tMax, [&](unsigned first, unsigned count, float &tClosest) {
+        for (unsigned chunk = first; chunk < first + count; chunk += RayPacket::WIDTH) {
+            unsigned chunkSize = std::min<unsigned>(RayPacket::WIDTH, first + count - chunk);
+            intersectSpheres(iRay, chunk, chunkSize, t);
+            for (unsigned k = 0; k < chunkSize; ++k) blocked |= t[k] < maxDist;
+        }
+        if (blocked) tClosest = -INFINITY;
+    });
+    return blocked;
+}
+
+void SphereGroup::shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const {
+    spheres[rec.primId]->shade(iRay, rec, inter);
+}
+
+std::ostream &SphereGroup::printInfo(std::ostream &os) const {
+    os << "  - SphereGroup -" << std::endl << "spheres: " << spheres.size();
+    for (const auto &sphere : spheres) os << std::endl << *sphere;
+    return os;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "BVH.hpp"
+#include "Ray.hpp"
+#include "RayPacket.hpp"
+#include "BasicObject.hpp"
+#include "Sphere.hpp"
+
+//!  The SphereGroup class.
+/**
+    \class SphereGroup
+  @brief The spheres of a scene, intersected together. Their centers and radii are stored as
+  structures of arrays, in the order of the leaves of a BVH, so that a ray is tested against the
+  spheres of a leaf in one vectorized iteration. The spheres keep their own material: the hit
+  record gives the index of the sphere hit in the group, and the scene shades that sphere.
+*/
+class SphereGroup : public BasicObject {
+protected:
+    /**
+     * @brief The spheres of the group, in the order of the leaves, used for their material.
+     *
+     */
+    std::vector<std::shared_ptr<Sphere>> spheres;
+
+    /**
+     * @brief The index of each sphere in the order in which they were given, used to break the
+     * ties so that the first sphere of the scene wins whatever the traversal order.
+     *
+     */
+    std::vector<unsigned> addedIds;
+
+    /**
+     * @brief The coordinates of the centers, one array per axis, and the squared radii.
+     *
+     */
+    std::vector<float> center[3];
+    std::vector<float> radius2;
+
+    /**
+     * @brief The acceleration structure over the spheres, whose leaves hold up to 8 spheres
+     * (fewer if RayPacket::WIDTH is smaller), or more when the surface area heuristic finds no
+     * useful split.
+     *
+     */
+    BVH bvh;
+
+    /**
+     * @brief The intersection of a ray with consecutive spheres, whose roots are computed in the
+     * numerically stable way so that they do not cancel out for the small or the distant spheres.
+     *
+     * @param iRay the incoming ray, of normalized direction
+     * @param first the index of the first sphere
+     * @param count the number of spheres, at most RayPacket::WIDTH
+     * @param t the distance of the closest intersection in front of the ray with each sphere,
+     * INFINITY if it misses
+     */
+    void intersectSpheres(const Ray &iRay, unsigned first, unsigned count, float *t) const;
+
+    /**
+     * @brief The same intersection for a packet of rays with one sphere.
+     *
+     * @param packet the incoming rays
+     * @param id the sphere
+     * @param t the distance of the intersection for each ray, INFINITY if it misses
+     */
+    void intersectPacket(const RayPacket &packet, unsigned id, float *t) const;
+
+public:
+    /**
+     * @brief Finds the closest sphere hit by a ray, the first one of the scene winning the ties.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, whose primId is the index of the sphere in the group
+     * @return true if a sphere is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const override;
+
+    /**
+     * @brief Finds the closest spheres hit by a packet of rays, walking through the BVH once for
+     * the whole packet and testing each sphere against all the rays with the vectorized kernel.
+     *
+     * @param packet the incoming rays
+     * @param hits the closest hits of the rays, whose primId is the index of the hit sphere
+     */
+    void hitPacket(const RayPacket &packet, PacketHit &hits) const override;
+
+    /**
+     * @brief Tells whether a sphere blocks a ray before maxDist.
+     *
+     * @param iRay the incoming ray
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if a sphere is hit closer than maxDist
+     */
+    bool occluded(const Ray &iRay, float maxDist) const override;
+
+    /**
+     * @brief Computes the normal and the material of the sphere hit.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
+     * @param inter the data about the intersection
+     */
+    void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const override;
+
+    /**
+     * @brief Get the sphere hit, whose material is used by the shading
+     *
+     * @param primId the index of the sphere in the group
+     * @return const BasicObject*
+     */
+    const BasicObject *getHitObject(unsigned primId) const override {
+        return spheres[primId].get();
+    }
+
+    /**
+     * @brief Get the box containing all the spheres
+     *
+     * @return AABB
+     */
+    AABB getBounds() const override { return bvh.getBounds(); }
+
+    /**
+     * @brief Get the number of spheres of the group
+     *
+     * @return unsigned
+     */
+    unsigned getNumberOfSpheres() const { return spheres.size(); }
+
+    /**
+     * @brief Construct a new Sphere Group object and build its BVH
+     *
+     * @param spheres the spheres, at least one
+     */
+    explicit SphereGroup(const std::vector<std::shared_ptr<Sphere>> &spheres);
+
+protected:
+    //! @brief A normal member taking one argument and returning the information about
+    //! an object. It replaces the pure virtual member of PhysicalObject
+    /**
+      @param os the current ostream
+      @return The information of the object as an ostream
+    */
+    std::ostream &printInfo(std::ostream &os) const override;
+};
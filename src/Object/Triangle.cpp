@@ -1,7 +1,6 @@
 #include "Triangle.hpp"
 
-void Triangle::intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                         std::vector<Ray> &rays) const {
+bool Triangle::intersectDistance(const Ray &iRay, float &t) const {
     // Intersect or not ? Moller Trumbore algorithm (from scratchapixels)
     glm::vec3 v0v1 = pos1 - pos;
     glm::vec3 v0v2 = pos2 - pos;
@@ -9,47 +8,87 @@ void Triangle::intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, I
     float det = glm::dot(v0v1, pvec);
 
     // ray and triangle are parallel if det is close to 0
-    if (fabs(det) < KEPSILON) return;
+    if (fabs(det) < KEPSILON) return false;
     float invDet = 1 / det;
 
     glm::vec3 tvec = iRay.getInitPt() - pos;
     float u = glm::dot(tvec, pvec) * invDet;
-    if (u < 0 || u > 1) return;
+    if (u < 0 || u > 1) return false;
 
     glm::vec3 qvec = glm::cross(tvec, v0v1);
     float v = glm::dot(iRay.getDir(), qvec) * invDet;
-    if (v < 0 || u + v > 1) return;
+    if (v < 0 || u + v > 1) return false;
 
     // distance to intersection
-    float t = glm::dot(v0v2, qvec) * invDet;
-    if (t < 0) return;
+    float dist = glm::dot(v0v2, qvec) * invDet;
+    if (dist < 0) return false;
+    t = dist;
+    return true;
+}
+
+bool Triangle::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    float t;
+    if (!intersectDistance(iRay, t) || t >= tMax) return false;
+    rec.t = t;
+    rec.primId = 0;
+    return true;
+}
 
-    inter.id = t;
-    glm::vec3 intersectPt = iRay.getInitPt() + inter.id * iRay.getDir();
+void Triangle::shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const {
+    glm::vec3 intersectPt = iRay.getInitPt() + rec.t * iRay.getDir();
+    inter.id = rec.t;
     inter.normal = normal;
-    ltSrc->outboundRays(intersectPt, rays);
-    inter.ld = glm::distance(intersectPt, ltSrc->pos);
-    inter.rColor = rays[0].getColor();
-
-    inter.objAlbedo = this->albedo;
-    inter.objReflexionIndex = this->reflexionIndex;
-
-    if (!definedTexture()) {
-        inter.objColor = this->color;
-        inter.objTransparency = this->transparency;
-    } else {
-        bool onTexture = false;
-        glm::vec4 tmp = this->getTexture()->getColor(intersectPt, onTexture);
-        if (onTexture) {
-            inter.objColor = glm::vec3(tmp[0], tmp[1], tmp[2]);
-            inter.objTransparency = tmp[3];
-        } else {
-            inter.objColor = this->color;
-            inter.objTransparency = this->transparency;
-        }
+    shadeMaterial(intersectPt, iRay.getFootprint(rec.t, inter.normal), inter);
+}
+
+void Triangle::intersectPacket(const RayPacket &packet, float *t) const {
+    const glm::vec3 v0v1 = pos1 - pos;
+    const glm::vec3 v0v2 = pos2 - pos;
+#pragma omp simd
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        // pvec = dir x v0v2
+        float pX = packet.dy[lane] * v0v2.z - v0v2.y * packet.dz[lane];
+        float pY = packet.dz[lane] * v0v2.x - v0v2.z * packet.dx[lane];
+        float pZ = packet.dx[lane] * v0v2.y - v0v2.x * packet.dy[lane];
+        float det = v0v1.x * pX + v0v1.y * pY + v0v1.z * pZ;
+        float invDet = 1 / det;
+
+        float tX = packet.ox[lane] - pos.x;
+        float tY = packet.oy[lane] - pos.y;
+        float tZ = packet.oz[lane] - pos.z;
+        float u = (tX * pX + tY * pY + tZ * pZ) * invDet;
+
+        // qvec = tvec x v0v1
+        float qX = tY * v0v1.z - v0v1.y * tZ;
+        float qY = tZ * v0v1.x - v0v1.z * tX;
+        float qZ = tX * v0v1.y - v0v1.x * tY;
+        float v = (packet.dx[lane] * qX + packet.dy[lane] * qY + packet.dz[lane] * qZ) * invDet;
+
+        float dist = (v0v2.x * qX + v0v2.y * qY + v0v2.z * qZ) * invDet;
+        // the same rejections as the scalar version, NaN included
+        bool hit = !(fabs(det) < KEPSILON) && !(u < 0 || u > 1) && !(v < 0 || u + v > 1) &&
+                   !(dist < 0);
+        t[lane] = hit ? dist : INFINITY;
+    }
+}
+
+void Triangle::hitPacket(const RayPacket &packet, PacketHit &hits) const {
+    alignas(64) float t[RayPacket::WIDTH];
+    intersectPacket(packet, t);
+#pragma omp simd
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        bool closer = t[lane] < hits.t[lane];
+        hits.t[lane] = closer ? t[lane] : hits.t[lane];
+        hits.primId[lane] = closer ? 0 : hits.primId[lane];
+        hits.id[lane] = closer ? 0 : hits.id[lane];
     }
 }
 
+bool Triangle::occluded(const Ray &iRay, float maxDist) const {
+    float t;
+    return intersectDistance(iRay, t) && t < maxDist;
+}
+
 std::ostream &Triangle::printInfo(std::ostream &os) const {
     return os << "  - Triangle -" << std::endl
               << "v0: " << pos << std::endl
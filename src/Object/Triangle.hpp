@@ -39,15 +39,61 @@ public:
     glm::vec3 normal;
 
     /**
-     * @brief
+     * @brief Finds the distance of the intersection between the triangle and a ray.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, modified only if there is a hit
+     * @return true if the triangle is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const override;
+
+    /**
+     * @brief Computes the normal and the material at an intersection found by hit.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
+     * @param inter the intersection object which contains the intersection information
+     */
+    void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const override;
+
+    /**
+     * @brief Vectorized hit query of a packet of rays against the triangle.
+     *
+     * @param packet the incoming rays
+     * @param hits the closest hits of the rays, lowered for the rays hitting the triangle
+     */
+    void hitPacket(const RayPacket &packet, PacketHit &hits) const override;
+
+    /**
+     * @brief The Moller Trumbore intersection of all the rays of a packet, with the same
+     * arithmetic as the scalar one.
      *
-     * @param iRay
-     * @param ltSrc
-     * @param inter
-     * @param rays
+     * @param packet the incoming rays
+     * @param t the distance of the intersection for each ray, INFINITY if it misses
      */
-    void intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                   std::vector<Ray> &rays) const override;
+    void intersectPacket(const RayPacket &packet, float *t) const;
+
+    /**
+     * @brief Tells whether the triangle blocks a ray before maxDist.
+     *
+     * @param iRay the incoming ray
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if the triangle is hit closer than maxDist
+     */
+    bool occluded(const Ray &iRay, float maxDist) const override;
+
+    /**
+     * @brief Get the box containing the three vertices
+     *
+     * @return AABB
+     */
+    AABB getBounds() const override {
+        AABB bounds(pos, pos);
+        bounds.expand(pos1);
+        bounds.expand(pos2);
+        return bounds;
+    }
 
     /**
      * @brief
@@ -84,6 +130,16 @@ public:
     }
 
 protected:
+    /**
+     * @brief The Moller Trumbore intersection shared by hit and occluded. It gives up as soon as
+     * the ray is known to miss the triangle.
+     *
+     * @param iRay the incoming ray
+     * @param t the distance of the intersection, modified only if there is one
+     * @return true if the ray hits the triangle in front of its origin
+     */
+    bool intersectDistance(const Ray &iRay, float &t) const;
+
     //! @brief A normal member taking one argument and returning the information about
     //! an object. It replaces the pure virtual member of PhysicalObject
     /**
@@ -1,28 +1,253 @@
 #include "TriangleMesh.hpp"
 
-void TriangleMesh::intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                             std::vector<Ray> &rays) const {
-    float minDistance = INFINITY;
-    Inter interTemp;
-    for (Triangle triangle : triangles) {
-        std::vector<Ray> raysTemp;
-        triangle.intersect(iRay, ltSrc, interTemp, raysTemp);
-
-        // check that intersection is non void and look for minimum value
-        if (interTemp.id != -1 && interTemp.id < minDistance) {
-
-            minDistance = interTemp.id;
-            inter = Inter(interTemp);
-            rays = raysTemp;
+TriangleMesh::TriangleMesh(const PolygonMesh &polyMesh) : vertices(polyMesh.getPositions()) {
+    reflexionIndex = 0;
+    refractiveIndex = 0;
+    transparency = 0;
+    albedo = 0.18;
+
+    // The first triangle of each polygon, a polygon of n corners giving n - 2 triangles
+    const std::vector<unsigned> &faceOffsets = polyMesh.getFaceOffsets();
+    const std::vector<PolygonMesh::Corner> &corners = polyMesh.getCorners();
+    const int polygonNb = polyMesh.getPolygonCount();
+    std::vector<unsigned> firstTriangle(polygonNb + 1, 0);
+    for (int polyId = 0; polyId < polygonNb; ++polyId) {
+        const unsigned cornerNb = faceOffsets[polyId + 1] - faceOffsets[polyId];
+        firstTriangle[polyId + 1] = firstTriangle[polyId] + (cornerNb > 2 ? cornerNb - 2 : 0);
+    }
+    indices.resize(3 * firstTriangle[polygonNb]);
+    normals.resize(firstTriangle[polygonNb]);
+
+#pragma omp parallel for schedule(static)
+    for (int polyId = 0; polyId < polygonNb; ++polyId) {
+        const unsigned first = faceOffsets[polyId];
+        if (firstTriangle[polyId] == firstTriangle[polyId + 1]) continue;
+        const unsigned normalId = corners[first].normal;
+        const glm::vec3 normal = normalId != PolygonMesh::NONE ? polyMesh.getNormals()[normalId]
+                                                               : glm::vec3(1, 1, 1);
+        unsigned id = firstTriangle[polyId];
+        for (unsigned corner = first + 1; corner + 1 < faceOffsets[polyId + 1]; ++corner) {
+            setTriangle(id++, corners[first].position, corners[corner].position,
+                        corners[corner + 1].position, normal);
+        }
+    }
+    build();
+}
+
+void TriangleMesh::setTriangle(unsigned id, unsigned i0, unsigned i1, unsigned i2,
+                               const glm::vec3 &n) {
+    indices[3 * id] = i0;
+    indices[3 * id + 1] = i1;
+    indices[3 * id + 2] = i2;
+    if (n.x == 1 && n.y == 1 && n.z == 1) {
+        normals[id] = glm::normalize(
+            glm::cross(vertices[i1] - vertices[i0], vertices[i2] - vertices[i0]));
+    } else {
+        normals[id] = glm::normalize(n);
+    }
+}
+
+void TriangleMesh::build() {
+    const unsigned triangleNb = normals.size();
+
+    std::vector<AABB> triangleBounds(triangleNb);
+    for (unsigned id = 0; id < triangleNb; ++id) {
+        for (unsigned k = 0; k < 3; ++k) triangleBounds[id].expand(vertices[indices[3 * id + k]]);
+    }
+    bvh.build(triangleBounds);
+
+    // Store the triangles in the order of the leaves
+    std::vector<unsigned> order;
+    bvh.renumberPrimitives(order);
+    std::vector<unsigned> sortedIndices(3 * triangleNb);
+    std::vector<glm::vec3> sortedNormals(triangleNb);
+    for (unsigned id = 0; id < triangleNb; ++id) {
+        for (unsigned k = 0; k < 3; ++k) sortedIndices[3 * id + k] = indices[3 * order[id] + k];
+        sortedNormals[id] = normals[order[id]];
+    }
+    indices.swap(sortedIndices);
+    normals.swap(sortedNormals);
+    std::vector<unsigned> sortedAddedIds(triangleNb);
+    for (unsigned id = 0; id < triangleNb; ++id) {
+        sortedAddedIds[id] = addedIds.empty() ? order[id] : addedIds[order[id]];
+    }
+    addedIds.swap(sortedAddedIds);
+
+    buildEdges();
+}
+
+void TriangleMesh::buildEdges() {
+    const unsigned triangleNb = normals.size();
+    for (int axis = 0; axis < 3; ++axis) {
+        v0[axis].resize(triangleNb);
+        edge1[axis].resize(triangleNb);
+        edge2[axis].resize(triangleNb);
+    }
+    for (unsigned id = 0; id < triangleNb; ++id) {
+        const glm::vec3 &pos = vertices[indices[3 * id]];
+        const glm::vec3 v0v1 = vertices[indices[3 * id + 1]] - pos;
+        const glm::vec3 v0v2 = vertices[indices[3 * id + 2]] - pos;
+        for (int axis = 0; axis < 3; ++axis) {
+            v0[axis][id] = pos[axis];
+            edge1[axis][id] = v0v1[axis];
+            edge2[axis][id] = v0v2[axis];
         }
     }
 }
+
+void TriangleMesh::intersectTriangles(const Ray &iRay, unsigned first, unsigned count,
+                                      float *t) const {
+    const glm::vec3 origin = iRay.getInitPt();
+    const glm::vec3 dir = iRay.getDir();
+    const float *v0x = &v0[0][first], *v0y = &v0[1][first], *v0z = &v0[2][first];
+    const float *e1x = &edge1[0][first], *e1y = &edge1[1][first], *e1z = &edge1[2][first];
+    const float *e2x = &edge2[0][first], *e2y = &edge2[1][first], *e2z = &edge2[2][first];
+#pragma omp simd
+    for (unsigned k = 0; k < count; ++k) {
+        // pvec = dir x v0v2
+        float pX = dir.y * e2z[k] - e2y[k] * dir.z;
+        float pY = dir.z * e2x[k] - e2z[k] * dir.x;
+        float pZ = dir.x * e2y[k] - e2x[k] * dir.y;
+        float det = e1x[k] * pX + e1y[k] * pY + e1z[k] * pZ;
+        float invDet = 1 / det;
+
+        float tX = origin.x - v0x[k];
+        float tY = origin.y - v0y[k];
+        float tZ = origin.z - v0z[k];
+        float u = (tX * pX + tY * pY + tZ * pZ) * invDet;
+
+        // qvec = tvec x v0v1
+        float qX = tY * e1z[k] - e1y[k] * tZ;
+        float qY = tZ * e1x[k] - e1z[k] * tX;
+        float qZ = tX * e1y[k] - e1x[k] * tY;
+        float v = (dir.x * qX + dir.y * qY + dir.z * qZ) * invDet;
+
+        float dist = (e2x[k] * qX + e2y[k] * qY + e2z[k] * qZ) * invDet;
+        // the same rejections as Triangle, NaN included
+        bool hit = !(fabs(det) < KEPSILON) && !(u < 0 || u > 1) && !(v < 0 || u + v > 1) &&
+                   !(dist < 0);
+        t[k] = hit ? dist : INFINITY;
+    }
+}
+
+void TriangleMesh::intersectPacket(const RayPacket &packet, unsigned id, float *t) const {
+    const float v0x = v0[0][id], v0y = v0[1][id], v0z = v0[2][id];
+    const float e1x = edge1[0][id], e1y = edge1[1][id], e1z = edge1[2][id];
+    const float e2x = edge2[0][id], e2y = edge2[1][id], e2z = edge2[2][id];
+#pragma omp simd
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        // pvec = dir x v0v2
+        float pX = packet.dy[lane] * e2z - e2y * packet.dz[lane];
+        float pY = packet.dz[lane] * e2x - e2z * packet.dx[lane];
+        float pZ = packet.dx[lane] * e2y - e2x * packet.dy[lane];
+        float det = e1x * pX + e1y * pY + e1z * pZ;
+        float invDet = 1 / det;
+
+        float tX = packet.ox[lane] - v0x;
+        float tY = packet.oy[lane] - v0y;
+        float tZ = packet.oz[lane] - v0z;
+        float u = (tX * pX + tY * pY + tZ * pZ) * invDet;
+
+        // qvec = tvec x v0v1
+        float qX = tY * e1z - e1y * tZ;
+        float qY = tZ * e1x - e1z * tX;
+        float qZ = tX * e1y - e1x * tY;
+        float v = (packet.dx[lane] * qX + packet.dy[lane] * qY + packet.dz[lane] * qZ) * invDet;
+
+        float dist = (e2x * qX + e2y * qY + e2z * qZ) * invDet;
+        bool hit = !(fabs(det) < KEPSILON) && !(u < 0 || u > 1) && !(v < 0 || u + v > 1) &&
+                   !(dist < 0);
+        t[lane] = hit ? dist : INFINITY;
+    }
+}
+
+bool TriangleMesh::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    float minDistance = tMax;
+    unsigned closestId = normals.size();
+    alignas(64) float t[RayPacket::WIDTH];
+    bvh.traverseLeaves(iRay, minDistance, [&](unsigned first, unsigned count, float &tClosest) {
+        for (unsigned chunk = first; chunk < first + count; chunk += RayPacket::WIDTH) {
+            unsigned chunkSize = std::min<unsigned>(RayPacket::WIDTH, first + count - chunk);
+            intersectTriangles(iRay, chunk, chunkSize, t);
+            // look for minimum value. On shared edges, the first triangle added wins whatever the
+            // traversal order.
+            for (unsigned k = 0; k < chunkSize; ++k) {
+                if (t[k] < tClosest || (t[k] == tClosest && closestId < normals.size() &&
+                                        addedIds[chunk + k] < addedIds[closestId])) {
+                    tClosest = t[k];
+                    closestId = chunk + k;
+                }
+            }
+        }
+    });
+
+    if (closestId == normals.size()) return false;
+    rec.t = minDistance;
+    rec.primId = closestId;
+    return true;
+}
+
+void TriangleMesh::hitPacket(const RayPacket &packet, PacketHit &hits) const {
+    // The closest triangle of each ray, the first triangle added winning the ties as in hit
+    PacketHit closest;
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        closest.t[lane] = hits.t[lane];
+        closest.id[lane] = PacketHit::noHit;
+    }
+
+    alignas(64) float t[RayPacket::WIDTH];
+    bvh.traversePacket(packet, closest.t, [&](unsigned id) {
+        intersectPacket(packet, id, t);
+#pragma omp simd
+        for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+            bool found = closest.id[lane] != PacketHit::noHit;
+            bool closer = t[lane] < closest.t[lane] ||
+                          (t[lane] == closest.t[lane] && found &&
+                           addedIds[id] < addedIds[found ? closest.id[lane] : id]);
+            closest.t[lane] = closer ? t[lane] : closest.t[lane];
+            closest.id[lane] = closer ? id : closest.id[lane];
+        }
+    });
+
+    for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+        if (closest.id[lane] == PacketHit::noHit) continue;
+        hits.t[lane] = closest.t[lane];
+        hits.primId[lane] = closest.id[lane];
+        hits.id[lane] = closest.id[lane];
+    }
+}
+
+bool TriangleMesh::occluded(const Ray &iRay, float maxDist) const {
+    return bvh.traverseAny(iRay, maxDist, [&](unsigned id) {
+        float t;
+        intersectTriangles(iRay, id, 1, &t);
+        return t < maxDist;
+    });
+}
+
+void TriangleMesh::shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const {
+    glm::vec3 intersectPt = iRay.getInitPt() + rec.t * iRay.getDir();
+    inter.id = rec.t;
+    inter.normal = normals[rec.primId];
+    shadeMaterial(intersectPt, iRay.getFootprint(rec.t, inter.normal), inter);
+}
+
+Triangle TriangleMesh::getTriangle(unsigned id) const {
+    return Triangle(vertices[indices[3 * id]], vertices[indices[3 * id + 1]],
+                    vertices[indices[3 * id + 2]], normals[id], color, transparency,
+                    refractiveIndex, reflexionIndex, albedo);
+}
+
+void TriangleMesh::offset(const glm::vec3 &position) {
+    for (glm::vec3 &vertex : vertices) vertex = vertex + position;
+    build();
+}
+
 std::ostream &TriangleMesh::printInfo(std::ostream &os) const {
-    std::string stream;
     os << "  - TriangleMesh - \n"
-       << "Number of triangles: " << std::to_string(triangles.size()) << '\n';
-    for (Triangle triangle : triangles) {
-        os << triangle << std::endl;
+       << "Number of triangles: " << std::to_string(getNumberOfTriangles()) << '\n';
+    for (unsigned id = 0; id < getNumberOfTriangles(); ++id) {
+        os << getTriangle(id) << std::endl;
     }
     return os;
 }
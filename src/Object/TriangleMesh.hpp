@@ -10,63 +10,213 @@
 #include <glm/gtx/norm.hpp>
 #include <glm/vec3.hpp>
 
+#include "BVH.hpp"
 #include "Ray.hpp"
 #include "Texture.hpp"
 #include "BasicObject.hpp"
 #include "Triangle.hpp"
 #include "PolygonMesh.hpp"
 
+/**
+ * @class TriangleMesh
+ * @brief A group of triangles sharing the material of the mesh. The triangles are not stored as
+ * Triangle objects but as indices in a vertex buffer, and their intersection data is stored as
+ * structures of arrays, in the order of the leaves of the BVH.
+ *
+ */
 class TriangleMesh : public BasicObject {
+    friend class MeshCache;
+
 protected:
     /**
-     * @brief
+     * @brief The vertex buffer, shared by the triangles
+     *
+     */
+    std::vector<glm::vec3> vertices;
+
+    /**
+     * @brief The indices in vertices of the three vertices of each triangle
+     *
+     */
+    std::vector<unsigned> indices;
+
+    /**
+     * @brief The normal of each triangle
+     *
+     */
+    std::vector<glm::vec3> normals;
+
+    /**
+     * @brief The index of each triangle in the order in which they were added, used to break the
+     * ties so that the first triangle added wins on shared edges.
+     *
+     */
+    std::vector<unsigned> addedIds;
+
+    /**
+     * @brief The coordinates of the first vertex of each triangle, one array per axis.
+     *
+     */
+    std::vector<float> v0[3];
+
+    /**
+     * @brief The edges from the first vertex to the second one (edge1) and to the third one
+     * (edge2), one array per axis.
+     *
+     */
+    std::vector<float> edge1[3];
+    std::vector<float> edge2[3];
+
+    /**
+     * @brief The acceleration structure over the triangles, so that a ray is only tested against
+     * the triangles of the leaves it reaches.
+     *
+     */
+    BVH bvh;
+
+    /**
+     * @brief Set a triangle of the mesh, whose slot is already allocated. build must be called
+     * once all the triangles are set.
+     *
+     * @param id the index of the triangle
+     * @param i0 the index of the first vertex
+     * @param i1 the index of the second vertex
+     * @param i2 the index of the third vertex
+     * @param n the normal of the triangle, computed from the vertices if it equals (1, 1, 1) as
+     * for Triangle
+     */
+    void setTriangle(unsigned id, unsigned i0, unsigned i1, unsigned i2, const glm::vec3 &n);
+
+    /**
+     * @brief Build the BVH over the triangles, store them in the order of its leaves and compute
+     * their intersection data.
+     *
+     */
+    void build();
+
+    /**
+     * @brief Compute the intersection data of the triangles from their vertices, in their order
+     *
+     */
+    void buildEdges();
+
+    /**
+     * @brief The Moller Trumbore intersection of a ray with the triangles [first, first + count[,
+     * with the same arithmetic as Triangle. The triangles are independent, so that the loop is
+     * vectorized over them.
      *
+     * @param iRay the incoming ray
+     * @param first the first triangle
+     * @param count the number of triangles, at most RayPacket::WIDTH
+     * @param t the distance of the intersection with each triangle, INFINITY if it misses
      */
-    std::vector<Triangle> triangles;
+    void intersectTriangles(const Ray &iRay, unsigned first, unsigned count, float *t) const;
+
+    /**
+     * @brief The Moller Trumbore intersection of a packet of rays with one triangle.
+     *
+     * @param packet the incoming rays
+     * @param id the triangle
+     * @param t the distance of the intersection for each ray, INFINITY if it misses
+     */
+    void intersectPacket(const RayPacket &packet, unsigned id, float *t) const;
 
 public:
-    void intersect(const Ray &iRay, const std::shared_ptr<Light> &ltSrc, Inter &inter,
-                   std::vector<Ray> &rays) const override;
+    /**
+     * @brief Finds the closest triangle hit by a ray, walking through the BVH.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record, whose primId is the id of the hit triangle
+     * @return true if a triangle is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const override;
+
+    /**
+     * @brief Computes the normal and the material of the triangle hit.
+     *
+     * @param iRay the incoming ray
+     * @param rec the hit record filled by hit
+     * @param inter the data about the intersection
+     */
+    void shade(const Ray &iRay, const HitRecord &rec, Inter &inter) const override;
+
+    /**
+     * @brief Finds the closest triangles hit by a packet of rays, walking through the BVH once
+     * for the whole packet and testing the triangles with the vectorized kernel.
+     *
+     * @param packet the incoming rays
+     * @param hits the closest hits of the rays, whose primId is the id of the hit triangle
+     */
+    void hitPacket(const RayPacket &packet, PacketHit &hits) const override;
+
+    /**
+     * @brief Tells whether any triangle blocks a ray before maxDist. The walk through the BVH
+     * stops at the first blocking triangle, which is not necessarily the closest one.
+     *
+     * @param iRay the incoming ray
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if a triangle is hit closer than maxDist
+     */
+    bool occluded(const Ray &iRay, float maxDist) const override;
+
+    /**
+     * @brief Get the box containing all the triangles
+     *
+     * @return AABB
+     */
+    AABB getBounds() const override { return bvh.getBounds(); }
+
+    /**
+     * @brief Get the number of triangles of the mesh
+     *
+     * @return unsigned
+     */
+    unsigned getNumberOfTriangles() const { return normals.size(); }
+
+    /**
+     * @brief Get the normal of a triangle of the mesh
+     *
+     * @param id the index of the triangle, in the order of the leaves of the BVH
+     * @return const glm::vec3&
+     */
+    const glm::vec3 &getNormal(unsigned id) const { return normals[id]; }
 
     /**
-     * @brief Get the Triangles object
+     * @brief Get a triangle of the mesh, with the material of the mesh
      *
-     * @return std::vector<Triangle>
+     * @param id the index of the triangle, in the order of the leaves of the BVH
+     * @return Triangle
      */
-    std::vector<Triangle> getTriangles() const { return this->triangles; }
+    Triangle getTriangle(unsigned id) const;
 
     //! Public method
     /**
-        @brief Move the center of the mesh to the position
-        @param position new position of the center of the Triangle mesh
+        @brief Move all the vertices of the mesh
+        @param position the translation
     */
-    void offset(const glm::vec3 &position) const {
-        for (Triangle triangle : triangles) {
-            triangle.offset(position);
-        }
-    }
-    //! A specialized constructor.
+    void offset(const glm::vec3 &position);
     /**
-     * @brief Construct a new Triangle Mesh with the help of a polygon mesh.
+     * @brief Construct an empty Triangle Mesh
      *
-     * @param polyMesh
      */
-    explicit TriangleMesh(PolygonMesh &polyMesh) {
+    TriangleMesh() {
         reflexionIndex = 0;
         refractiveIndex = 0;
         transparency = 0;
         albedo = 0.18;
-        for (Polygon poly : polyMesh) {
-            std::vector<Triangle> polygonTriangles;
-            int verticeNb = poly.vertices.size();
-            for (int id = 1; id < verticeNb - 1; ++id) {
-                polygonTriangles.push_back(Triangle(poly.vertices[0], poly.vertices[id],
-                                                    poly.vertices[id + 1], poly.normal));
-            }
-            triangles.insert(triangles.end(), polygonTriangles.begin(), polygonTriangles.end());
-        }
     }
 
+    //! A specialized constructor.
+    /**
+     * @brief Construct a new Triangle Mesh with the help of a polygon mesh. The triangles share
+     * the vertex buffer of the polygon mesh, each polygon being split into a fan of triangles
+     * around its first corner, in parallel.
+     *
+     * @param polyMesh
+     */
+    explicit TriangleMesh(const PolygonMesh &polyMesh);
+
 protected:
     //! @brief A normal membser taking one argument and returning the information about
     //! an object. It replaces the pure virtual member of PhysicalObject
@@ -2,8 +2,16 @@
 
 #include <string>
 
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "MeshCache.hpp"
+#include "Object/AreaLight.hpp"
+#include "Object/Box.hpp"
+#include "Object/Instance.hpp"
 #include "Object/Plane.hpp"
+#include "Object/SpotLight.hpp"
 #include "Object/Sphere.hpp"
+#include "Object/SphereGroup.hpp"
 #include "Object/Triangle.hpp"
 
 
@@ -11,6 +19,16 @@ Parser::Parser(std::string xmlData) {
     doc.Parse(xmlData.c_str());
     auto scene = doc.FirstChildElement("scene");
 
+    // The images are decoded in the background while the rest of the scene is read
+    auto objectsTag = scene->FirstChildElement("objects");
+    for (auto objectTag = objectsTag->FirstChildElement(); objectTag != NULL;
+         objectTag = objectTag->NextSiblingElement()) {
+        auto textureTag = objectTag->FirstChildElement("texture");
+        auto imageTag = textureTag != NULL ? textureTag->FirstChildElement("image") : NULL;
+        auto pathTag = imageTag != NULL ? imageTag->FirstChildElement("path") : NULL;
+        if (pathTag != NULL) textures.prefetch("../data/" + (std::string)(pathTag->GetText()));
+    }
+
     // meta
     auto metaTag = scene->FirstChildElement("meta");
     name = metaTag->FirstChildElement("name")->GetText();
@@ -28,16 +46,33 @@ Parser::Parser(std::string xmlData) {
     camera = std::make_shared<Camera>(cameraPos, cameraDir, cameraSize.x, cameraSize.y, cameraPix.x,
                                       cameraPix.y, cameraFoc);
 
+    // optional, every light is used by default
+    auto lightSamplesTag = metaTag->FirstChildElement("light_samples");
+    lightSamples = lightSamplesTag != NULL ? std::stoi(lightSamplesTag->GetText()) : 0;
+
     // lightsources
-    auto lightTag = scene->FirstChildElement("lightsources");
-    auto dlightTag = lightTag->FirstChildElement("directLight");
-    auto dlightPos = getXYZ(dlightTag->FirstChildElement("pos"));
-    auto dlightColor = getRGB(dlightTag->FirstChildElement("color"));
-    auto dlightIntensity = std::stoi(dlightTag->FirstChildElement("intensity")->GetText());
-    sources.push_back(std::make_shared<DirectLight>(dlightPos, dlightColor, dlightIntensity));
-
-    // objects
-    auto objectsTag = scene->FirstChildElement("objects");
+    auto lightsTag = scene->FirstChildElement("lightsources");
+    for (auto lightTag = lightsTag->FirstChildElement(); lightTag != NULL;
+         lightTag = lightTag->NextSiblingElement()) {
+        std::string lightName = lightTag->Name();
+
+        auto lightPos = getXYZ(lightTag->FirstChildElement("pos"));
+        auto lightColor = getRGB(lightTag->FirstChildElement("color"));
+        auto lightIntensity = std::stof(lightTag->FirstChildElement("intensity")->GetText());
+
+        if (lightName == "directLight") {
+            sources.push_back(std::make_shared<DirectLight>(lightPos, lightColor, lightIntensity));
+        } else if (lightName == "spotLight") {
+            sources.push_back(std::make_shared<SpotLight>(lightPos, lightColor, lightIntensity));
+        } else if (lightName == "areaLight") {
+            sources.push_back(std::make_shared<AreaLight>(lightPos, lightColor, lightIntensity));
+        }
+    }
+
+    // objects, the spheres being gathered into one group, placed where the first sphere was so
+    // that the objects keep their order for the ties
+    std::vector<std::shared_ptr<Sphere>> spheres;
+    size_t firstSphere = 0;
     for (auto objectTag = objectsTag->FirstChildElement(); objectTag != NULL;
          objectTag = objectTag->NextSiblingElement()) {
         std::string objectName = objectTag->Name();
@@ -66,7 +101,10 @@ Parser::Parser(std::string xmlData) {
                 auto origin = getXYZ(imageTag->FirstChildElement("origin"));
                 auto wVec = getXYZ(imageTag->FirstChildElement("wVec"));
                 auto hVec = getXYZ(imageTag->FirstChildElement("hVec"));
-                image = std::make_shared<Image>(filename, origin, hVec, wVec);
+                image = std::make_shared<Image>(textures.get(filename), origin, hVec, wVec);
+                auto filterTag = imageTag->FirstChildElement("filter");
+                if (filterTag != NULL && (std::string)(filterTag->GetText()) == "bilinear")
+                    image->setFiltering(Image::BILINEAR);
                 foundImage = true;
             } else if (objectTexture != NULL &&
                        !((std::string)(objectTexture->FirstChildElement()->Name()))
@@ -102,7 +140,8 @@ Parser::Parser(std::string xmlData) {
             } else if (foundChecked) {
                 sphere->setTexture(checked);
             }
-            objects.push_back(sphere);
+            if (spheres.empty()) firstSphere = objects.size();
+            spheres.push_back(sphere);
         } else if (objectName == "triangle") {
             auto triangleV1 = getXYZ(objectTag->FirstChildElement("v1"));
             auto triangleV2 = getXYZ(objectTag->FirstChildElement("v2"));
@@ -116,8 +155,48 @@ Parser::Parser(std::string xmlData) {
                 triangle->setTexture(checked);
             }
             objects.push_back(triangle);
+        } else if (objectName == "box") {
+            auto boxSize = getXYZ(objectTag->FirstChildElement("size"));
+            auto box = std::make_shared<Box>(objectPos, boxSize, objectColor, objectTransmission,
+                                             objectRefractive, objectReflexion, objectAlbedo);
+            if (foundImage) {
+                box->setTexture(image);
+            } else if (foundChecked) {
+                box->setTexture(checked);
+            }
+            objects.push_back(box);
+        } else if (objectName == "mesh") {
+            auto filename =
+                "../data/" + (std::string)(objectTag->FirstChildElement("path")->GetText());
+            if (!meshes.count(filename)) meshes[filename] = MeshCache::load(filename);
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), objectPos);
+            auto rotationTag = objectTag->FirstChildElement("rotation");
+            if (rotationTag != NULL) {
+                auto angles = getXYZ(rotationTag);
+                transform = glm::rotate(transform, glm::radians(angles.z), glm::vec3(0, 0, 1));
+                transform = glm::rotate(transform, glm::radians(angles.y), glm::vec3(0, 1, 0));
+                transform = glm::rotate(transform, glm::radians(angles.x), glm::vec3(1, 0, 0));
+            }
+            auto scaleTag = objectTag->FirstChildElement("scale");
+            if (scaleTag != NULL) {
+                transform = glm::scale(transform, glm::vec3(std::stof(scaleTag->GetText())));
+            }
+            auto instance = std::make_shared<Instance>(meshes[filename], transform, objectColor,
+                                                       objectTransmission, objectRefractive,
+                                                       objectReflexion, objectAlbedo);
+            if (foundImage) {
+                instance->setTexture(image);
+            } else if (foundChecked) {
+                instance->setTexture(checked);
+            }
+            objects.push_back(instance);
         }
     }
+    if (spheres.size() == 1) {
+        objects.insert(objects.begin() + firstSphere, spheres[0]);
+    } else if (spheres.size() > 1) {
+        objects.insert(objects.begin() + firstSphere, std::make_shared<SphereGroup>(spheres));
+    }
 }
 
 glm::vec2 Parser::getXY(const tinyxml2::XMLElement* element) {
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 
 #include <glm/vec2.hpp>
@@ -19,6 +20,8 @@
 #include "Object/Camera.hpp"
 #include "Object/BasicObject.hpp"
 #include "Object/DirectLight.hpp"
+#include "Object/TriangleMesh.hpp"
+#include "TextureCache.hpp"
 
 /**
  * @class Parser
@@ -31,6 +34,7 @@ class Parser {
     std::string name;
     glm::vec2 size;
     int maxDepth;
+    unsigned lightSamples;
     glm::vec3 backgroundColor;
     std::vector<std::shared_ptr<BasicObject>> objects;
 
@@ -38,6 +42,14 @@ class Parser {
 
     std::shared_ptr<Camera> camera;
 
+    TextureCache textures;
+
+    /**
+     * @brief The meshes of the scene, keyed by the name of their file, shared by their instances.
+     *
+     */
+    std::map<std::string, std::shared_ptr<const TriangleMesh>> meshes;
+
 public:
     Parser() = delete;
     Parser(std::string xmlData);
@@ -45,6 +57,7 @@ public:
     std::string getName() const { return name; }
     glm::vec2 getSize() const { return size; }
     int getMaxDepth() const { return maxDepth; }
+    unsigned getLightSamples() const { return lightSamples; }
     glm::vec3 getBackgroundColor() const { return backgroundColor; }
 
     const std::vector<std::shared_ptr<BasicObject>>& getObjects() const { return objects; }
@@ -0,0 +1,461 @@
+/**
+ * @file PngStreamWriter.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A streaming PNG encoder, following the PNG specification and the DEFLATE format of the
+ * RFC 1951
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "PngStreamWriter.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "lodepng/lodepng.h"
+
+namespace {
+
+// Lengths and distances of the matches: base value and number of extra bits of each code
+const unsigned LENGTH_BASES[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                   31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const unsigned LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                   2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const unsigned DIST_BASES[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                 33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const unsigned DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order in which the lengths of the code of the code lengths are written
+const unsigned CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5,
+                                        11, 4,  12, 3, 13, 2, 14, 1, 15};
+
+unsigned lengthCode(unsigned length) {
+    return std::upper_bound(LENGTH_BASES, LENGTH_BASES + 29, length) - LENGTH_BASES - 1;
+}
+
+unsigned distCode(unsigned dist) {
+    return std::upper_bound(DIST_BASES, DIST_BASES + 30, dist) - DIST_BASES - 1;
+}
+
+/**
+ * @brief Give a frequency to the first unused symbols so that at least two symbols are used, some
+ * decoders rejecting the codes of a single symbol.
+ *
+ */
+void useTwoSymbols(std::vector<unsigned> &freqs) {
+    unsigned used = std::count_if(freqs.begin(), freqs.end(), [](unsigned f) { return f > 0; });
+    for (unsigned &freq : freqs) {
+        if (used >= 2) break;
+        if (!freq) {
+            freq = 1;
+            ++used;
+        }
+    }
+}
+
+/**
+ * @brief The lengths of the Huffman code of symbols of given frequencies. While the code is longer
+ * than maxLength, the frequencies are halved, which flattens the tree.
+ *
+ */
+std::vector<unsigned> huffmanLengths(std::vector<unsigned> freqs, unsigned maxLength) {
+    const unsigned symbolNb = freqs.size();
+    std::vector<unsigned> lengths(symbolNb, 0);
+    typedef std::pair<uint64_t, unsigned> Node;  // weight and id, the leaves being the symbols
+
+    while (true) {
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+        for (unsigned symbol = 0; symbol < symbolNb; ++symbol) {
+            if (freqs[symbol]) queue.push(Node(freqs[symbol], symbol));
+        }
+        std::vector<int> parents(2 * symbolNb, -1);
+        unsigned nextNode = symbolNb;
+        while (queue.size() > 1) {
+            Node first = queue.top();
+            queue.pop();
+            Node second = queue.top();
+            queue.pop();
+            parents[first.second] = nextNode;
+            parents[second.second] = nextNode;
+            queue.push(Node(first.first + second.first, nextNode++));
+        }
+
+        unsigned longest = 0;
+        for (unsigned symbol = 0; symbol < symbolNb; ++symbol) {
+            lengths[symbol] = 0;
+            if (!freqs[symbol]) continue;
+            for (int node = symbol; parents[node] >= 0; node = parents[node]) ++lengths[symbol];
+            lengths[symbol] = std::max(1u, lengths[symbol]);
+            longest = std::max(longest, lengths[symbol]);
+        }
+        if (longest <= maxLength) return lengths;
+
+        for (unsigned &freq : freqs) {
+            if (freq) freq = (freq + 1) / 2;
+        }
+    }
+}
+
+/**
+ * @brief The canonical Huffman codes of given lengths
+ *
+ */
+std::vector<uint32_t> canonicalCodes(const std::vector<unsigned> &lengths) {
+    unsigned lengthCounts[16] = {0};
+    for (unsigned length : lengths) {
+        if (length) ++lengthCounts[length];
+    }
+    uint32_t nextCodes[16] = {0};
+    uint32_t code = 0;
+    for (unsigned length = 1; length < 16; ++length) {
+        code = (code + lengthCounts[length - 1]) << 1;
+        nextCodes[length] = code;
+    }
+    std::vector<uint32_t> codes(lengths.size(), 0);
+    for (unsigned symbol = 0; symbol < lengths.size(); ++symbol) {
+        if (lengths[symbol]) codes[symbol] = nextCodes[lengths[symbol]]++;
+    }
+    return codes;
+}
+
+/**
+ * @brief Hash of the 3 bytes starting a match, on 15 bits
+ *
+ */
+uint32_t hash3(const unsigned char *bytes) {
+    return ((bytes[0] | bytes[1] << 8 | bytes[2] << 16) * 2654435761u) >> 17;
+}
+
+void writeBigEndian(unsigned char *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+}  // namespace
+
+ZlibStream::ZlibStream()
+    : inputBase(0),
+      pos(0),
+      head(HASH_SIZE, NONE),
+      prev(WINDOW_SIZE, NONE),
+      litLenFreqs(286, 0),
+      distFreqs(30, 0),
+      adlerA(1),
+      adlerB(0),
+      bitBuffer(0),
+      bitCount(0) {
+    // Deflate with a window of 32 KiB, default compression
+    output.push_back(0x78);
+    output.push_back(0x9C);
+}
+
+void ZlibStream::writeBits(uint32_t bits, unsigned count) {
+    bitBuffer |= (uint64_t)bits << bitCount;
+    bitCount += count;
+    while (bitCount >= 8) {
+        output.push_back(bitBuffer & 0xFF);
+        bitBuffer >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void ZlibStream::writeCode(uint32_t code, unsigned length) {
+    // The Huffman codes are written from their most significant bit
+    uint32_t reversed = 0;
+    for (unsigned bit = 0; bit < length; ++bit) {
+        reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+    }
+    writeBits(reversed, length);
+}
+
+void ZlibStream::insertHash(uint64_t position) {
+    if (position + MIN_MATCH > inputBase + input.size()) return;
+    const uint32_t hash = hash3(&input[position - inputBase]);
+    prev[position % WINDOW_SIZE] = head[hash];
+    head[hash] = position;
+}
+
+void ZlibStream::addSymbol(unsigned litLen, unsigned dist) {
+    symbols.push_back(Symbol{(uint16_t)litLen, (uint16_t)dist});
+    if (dist == 0) {
+        ++litLenFreqs[litLen];
+    } else {
+        ++litLenFreqs[257 + lengthCode(litLen)];
+        ++distFreqs[distCode(dist)];
+    }
+    if (symbols.size() >= BLOCK_SYMBOLS) writeBlock(false);
+}
+
+void ZlibStream::findMatch(uint64_t position, uint64_t end, unsigned &length,
+                           unsigned &dist) const {
+    const unsigned available = std::min<uint64_t>(MAX_MATCH, end - position);
+    const unsigned char *current = &input[position - inputBase];
+    length = 0;
+    dist = 0;
+    if (available < MIN_MATCH) return;
+
+    // Longest match among the last positions with the same hash
+    uint64_t candidate = head[hash3(current)];
+    for (unsigned chain = 0; chain < MAX_CHAIN && candidate != NONE; ++chain) {
+        if (position - candidate > WINDOW_SIZE) break;
+        const unsigned char *match = &input[candidate - inputBase];
+        unsigned matchLength = 0;
+        while (matchLength < available && match[matchLength] == current[matchLength]) {
+            ++matchLength;
+        }
+        if (matchLength > length) {
+            length = matchLength;
+            dist = position - candidate;
+            if (length == available) break;
+        }
+        uint64_t previous = prev[candidate % WINDOW_SIZE];
+        if (previous == NONE || previous >= candidate) break;
+        candidate = previous;
+    }
+
+    // A far match of 3 bytes costs more than the literals
+    if (length < MIN_MATCH || (length == MIN_MATCH && dist > 4096)) length = 0;
+}
+
+void ZlibStream::compress(bool finishing) {
+    const uint64_t end = inputBase + input.size();
+    const uint64_t limit = finishing ? end : (end > MAX_MATCH ? end - MAX_MATCH : 0);
+
+    while (pos < limit) {
+        unsigned length, dist;
+        findMatch(pos, end, length, dist);
+        insertHash(pos);
+
+        // Lazy matching: a literal is emitted if the next byte starts a longer match
+        if (length && length < LAZY_LENGTH && pos + 1 < limit) {
+            unsigned nextLength, nextDist;
+            findMatch(pos + 1, end, nextLength, nextDist);
+            if (nextLength > length) length = 0;
+        }
+
+        if (length) {
+            addSymbol(length, dist);
+            for (unsigned k = 1; k < length; ++k) insertHash(pos + k);
+            pos += length;
+        } else {
+            addSymbol(input[pos - inputBase], 0);
+            ++pos;
+        }
+    }
+
+    // Only the window of the matches is kept before pos
+    if (pos - inputBase > 2 * WINDOW_SIZE) {
+        uint64_t newBase = pos - WINDOW_SIZE;
+        input.erase(input.begin(), input.begin() + (newBase - inputBase));
+        inputBase = newBase;
+    }
+}
+
+void ZlibStream::writeBlock(bool final) {
+    std::vector<unsigned> litLenCounts = litLenFreqs;
+    std::vector<unsigned> distCounts = distFreqs;
+    litLenCounts[256] = 1;  // end of block
+    useTwoSymbols(litLenCounts);
+    useTwoSymbols(distCounts);
+    const std::vector<unsigned> litLenLengths = huffmanLengths(litLenCounts, 15);
+    const std::vector<unsigned> distLengths = huffmanLengths(distCounts, 15);
+    const std::vector<uint32_t> litLenCodes = canonicalCodes(litLenLengths);
+    const std::vector<uint32_t> distCodes = canonicalCodes(distLengths);
+
+    unsigned litLenNb = 286;
+    while (litLenNb > 257 && !litLenLengths[litLenNb - 1]) --litLenNb;
+    unsigned distNb = 30;
+    while (distNb > 1 && !distLengths[distNb - 1]) --distNb;
+
+    // Run length encoding of the code lengths: 16 repeats the previous length 3 to 6 times, 17
+    // and 18 repeat zeros 3 to 10 and 11 to 138 times.
+    std::vector<unsigned> lengths(litLenLengths.begin(), litLenLengths.begin() + litLenNb);
+    lengths.insert(lengths.end(), distLengths.begin(), distLengths.begin() + distNb);
+    std::vector<std::pair<unsigned, unsigned>> runs;  // symbol and extra bits
+    std::vector<unsigned> codeLengthFreqs(19, 0);
+    for (unsigned id = 0; id < lengths.size();) {
+        const unsigned value = lengths[id];
+        unsigned run = 1;
+        while (id + run < lengths.size() && lengths[id + run] == value) ++run;
+        if (value == 0 && run >= 3) {
+            unsigned count = std::min(run, 138u);
+            runs.push_back(count >= 11 ? std::make_pair(18u, count - 11)
+                                       : std::make_pair(17u, count - 3));
+            id += count;
+        } else {
+            runs.push_back(std::make_pair(value, 0u));
+            ++id;
+            --run;
+            while (run >= 3) {
+                unsigned count = std::min(run, 6u);
+                runs.push_back(std::make_pair(16u, count - 3));
+                id += count;
+                run -= count;
+            }
+        }
+    }
+    for (const auto &run : runs) ++codeLengthFreqs[run.first];
+    useTwoSymbols(codeLengthFreqs);
+    const std::vector<unsigned> codeLengthLengths = huffmanLengths(codeLengthFreqs, 7);
+    const std::vector<uint32_t> codeLengthCodes = canonicalCodes(codeLengthLengths);
+    unsigned codeLengthNb = 19;
+    while (codeLengthNb > 4 && !codeLengthLengths[CODE_LENGTH_ORDER[codeLengthNb - 1]]) {
+        --codeLengthNb;
+    }
+
+    // Header of the block and codes
+    writeBits(final, 1);
+    writeBits(2, 2);
+    writeBits(litLenNb - 257, 5);
+    writeBits(distNb - 1, 5);
+    writeBits(codeLengthNb - 4, 4);
+    for (unsigned id = 0; id < codeLengthNb; ++id) {
+        writeBits(codeLengthLengths[CODE_LENGTH_ORDER[id]], 3);
+    }
+    for (const auto &run : runs) {
+        writeCode(codeLengthCodes[run.first], codeLengthLengths[run.first]);
+        if (run.first == 16) writeBits(run.second, 2);
+        if (run.first == 17) writeBits(run.second, 3);
+        if (run.first == 18) writeBits(run.second, 7);
+    }
+
+    // Data
+    for (const Symbol &symbol : symbols) {
+        if (symbol.dist == 0) {
+            writeCode(litLenCodes[symbol.litLen], litLenLengths[symbol.litLen]);
+            continue;
+        }
+        unsigned code = lengthCode(symbol.litLen);
+        writeCode(litLenCodes[257 + code], litLenLengths[257 + code]);
+        writeBits(symbol.litLen - LENGTH_BASES[code], LENGTH_EXTRA[code]);
+        code = distCode(symbol.dist);
+        writeCode(distCodes[code], distLengths[code]);
+        writeBits(symbol.dist - DIST_BASES[code], DIST_EXTRA[code]);
+    }
+    writeCode(litLenCodes[256], litLenLengths[256]);
+
+    symbols.clear();
+    std::fill(litLenFreqs.begin(), litLenFreqs.end(), 0);
+    std::fill(distFreqs.begin(), distFreqs.end(), 0);
+}
+
+void ZlibStream::write(const unsigned char *data, size_t size) {
+    // Adler-32, reduced every 5552 bytes before it overflows
+    for (size_t first = 0; first < size; first += 5552) {
+        size_t last = std::min(size, first + 5552);
+        for (size_t id = first; id < last; ++id) {
+            adlerA += data[id];
+            adlerB += adlerA;
+        }
+        adlerA %= 65521;
+        adlerB %= 65521;
+    }
+
+    input.insert(input.end(), data, data + size);
+    compress(false);
+}
+
+void ZlibStream::finish() {
+    compress(true);
+    writeBlock(true);
+    if (bitCount) writeBits(0, 8 - bitCount);
+
+    unsigned char adler[4];
+    writeBigEndian(adler, adlerB << 16 | adlerA);
+    output.insert(output.end(), adler, adler + 4);
+}
+
+PngStreamWriter::PngStreamWriter(const std::string &filename, unsigned w, unsigned h)
+    : file(filename, std::ios::binary), width(w), height(h), rowCount(0), previousRow(4 * w, 0) {
+    if (!file.is_open()) throw std::runtime_error("Cannot write the image " + filename);
+    for (auto &row : filteredRows) row.resize(4 * width + 1);
+
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    file.write((const char *)signature, 8);
+
+    // 8 bits RGBA, no interlacing
+    unsigned char header[13] = {0, 0, 0, 0, 0, 0, 0, 0, 8, 6, 0, 0, 0};
+    writeBigEndian(header, width);
+    writeBigEndian(header + 4, height);
+    writeChunk("IHDR", header, 13);
+}
+
+void PngStreamWriter::writeChunk(const char *type, const unsigned char *data, size_t size) {
+    std::vector<unsigned char> chunk(12 + size);
+    writeBigEndian(chunk.data(), size);
+    std::memcpy(&chunk[4], type, 4);
+    if (size) std::memcpy(&chunk[8], data, size);
+    lodepng_chunk_generate_crc(chunk.data());
+    file.write((const char *)chunk.data(), chunk.size());
+}
+
+void PngStreamWriter::flushData(bool all) {
+    const size_t chunkSize = 65536;
+    std::vector<unsigned char> &data = zlib.getOutput();
+    size_t first = 0;
+    while (data.size() - first >= chunkSize || (all && first < data.size())) {
+        size_t size = std::min(chunkSize, data.size() - first);
+        writeChunk("IDAT", &data[first], size);
+        first += size;
+    }
+    data.erase(data.begin(), data.begin() + first);
+}
+
+void PngStreamWriter::writeRow(const unsigned char *rgba) {
+    if (rowCount == height) throw std::runtime_error("Too many rows for the PNG image");
+
+    // Each filter predicts the bytes from the left (a), up (b) and up left (c) pixels
+    const unsigned size = 4 * width;
+    const unsigned char *up = previousRow.data();
+    for (unsigned filter = 0; filter < 5; ++filter) filteredRows[filter][0] = filter;
+    for (unsigned id = 0; id < size; ++id) {
+        const int a = id >= 4 ? rgba[id - 4] : 0;
+        const int b = up[id];
+        const int c = id >= 4 ? up[id - 4] : 0;
+        const int p = a + b - c;
+        const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        const int paeth = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+        filteredRows[0][id + 1] = rgba[id];
+        filteredRows[1][id + 1] = rgba[id] - a;
+        filteredRows[2][id + 1] = rgba[id] - b;
+        filteredRows[3][id + 1] = rgba[id] - (a + b) / 2;
+        filteredRows[4][id + 1] = rgba[id] - paeth;
+    }
+
+    // The filter whose bytes are the closest to 0 compresses best
+    unsigned bestFilter = 0;
+    uint64_t bestSum = ~uint64_t(0);
+    for (unsigned filter = 0; filter < 5; ++filter) {
+        uint64_t sum = 0;
+        for (unsigned id = 1; id <= size; ++id) {
+            unsigned char value = filteredRows[filter][id];
+            sum += (filter == 0 || value < 128) ? value : 256 - value;
+        }
+        if (sum < bestSum) {
+            bestSum = sum;
+            bestFilter = filter;
+        }
+    }
+
+    zlib.write(filteredRows[bestFilter].data(), size + 1);
+    std::memcpy(previousRow.data(), rgba, size);
+    ++rowCount;
+    flushData(false);
+}
+
+void PngStreamWriter::close() {
+    if (rowCount != height) throw std::runtime_error("The PNG image is incomplete");
+    zlib.finish();
+    flushData(true);
+    writeChunk("IEND", nullptr, 0);
+    file.close();
+}
@@ -0,0 +1,207 @@
+/**
+ * @file PngStreamWriter.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief A PNG encoder compressing the rows of the image as they are given, so that the image
+ * never has to be held in memory as a whole
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A zlib (deflate) compressor fed by successive pieces of data. The matches are searched in
+ * the last 32 KiB of the data, and each block of symbols is written with its own Huffman codes, so
+ * that its memory does not depend on the size of the data.
+ * @class ZlibStream
+ */
+class ZlibStream {
+protected:
+    static constexpr unsigned WINDOW_SIZE = 32768;
+    static constexpr unsigned HASH_SIZE = 32768;
+    static constexpr unsigned MIN_MATCH = 3;
+    static constexpr unsigned MAX_MATCH = 258;
+    static constexpr unsigned MAX_CHAIN = 64;
+    static constexpr unsigned LAZY_LENGTH = 32;
+    static constexpr unsigned BLOCK_SYMBOLS = 16384;
+    static constexpr uint64_t NONE = ~uint64_t(0);
+
+    /**
+     * @brief A literal (dist == 0) or a match of length litLen at distance dist.
+     *
+     */
+    struct Symbol {
+        uint16_t litLen;
+        uint16_t dist;
+    };
+
+    /**
+     * @brief The data not compressed yet, preceded by the window of the matches. input[0] is the
+     * byte number inputBase of the stream.
+     *
+     */
+    std::vector<unsigned char> input;
+    uint64_t inputBase;
+
+    /**
+     * @brief The number of the next byte to compress.
+     *
+     */
+    uint64_t pos;
+
+    /**
+     * @brief The last position of each hash of 3 bytes, and for each position of the window the
+     * previous position with the same hash.
+     *
+     */
+    std::vector<uint64_t> head;
+    std::vector<uint64_t> prev;
+
+    /**
+     * @brief The symbols of the current block, and their frequencies.
+     *
+     */
+    std::vector<Symbol> symbols;
+    std::vector<unsigned> litLenFreqs;
+    std::vector<unsigned> distFreqs;
+
+    /**
+     * @brief The checksum of the data.
+     *
+     */
+    uint32_t adlerA;
+    uint32_t adlerB;
+
+    /**
+     * @brief The bits not yet written to output.
+     *
+     */
+    uint64_t bitBuffer;
+    unsigned bitCount;
+
+    /**
+     * @brief The compressed bytes not yet taken by the user.
+     *
+     */
+    std::vector<unsigned char> output;
+
+    void writeBits(uint32_t bits, unsigned count);
+    void writeCode(uint32_t code, unsigned length);
+
+    /**
+     * @brief Compress the input up to the last MAX_MATCH bytes, which may still be extended, or
+     * up to the end when finishing.
+     *
+     */
+    void compress(bool finishing);
+    void insertHash(uint64_t position);
+
+    /**
+     * @brief The longest match of the data at position with the data of the window.
+     *
+     * @param position the position of the data
+     * @param end the end of the data
+     * @param length the length of the match, 0 if there is no match worth it
+     * @param dist the distance of the match
+     */
+    void findMatch(uint64_t position, uint64_t end, unsigned &length, unsigned &dist) const;
+    void addSymbol(unsigned litLen, unsigned dist);
+
+    /**
+     * @brief Write the current block with dynamic Huffman codes.
+     *
+     * @param final true for the last block of the stream
+     */
+    void writeBlock(bool final);
+
+public:
+    /**
+     * @brief Compress more data
+     *
+     * @param data the data
+     * @param size the number of bytes
+     */
+    void write(const unsigned char *data, size_t size);
+
+    /**
+     * @brief Compress the remaining data and end the stream with its checksum.
+     *
+     */
+    void finish();
+
+    /**
+     * @brief The compressed bytes produced so far and not taken yet. They may be moved out by the
+     * user.
+     *
+     * @return std::vector<unsigned char>&
+     */
+    std::vector<unsigned char> &getOutput() { return this->output; }
+
+    /**
+     * @brief Construct a new Zlib Stream object and write the zlib header.
+     *
+     */
+    explicit ZlibStream();
+};
+
+/**
+ * @brief Writes a RGBA PNG file row by row. The rows are filtered and compressed as soon as they
+ * are given, and the compressed data is written to the file in IDAT chunks of 64 KiB: only a few
+ * rows are kept in memory, whatever the size of the image.
+ * @class PngStreamWriter
+ */
+class PngStreamWriter {
+protected:
+    std::ofstream file;
+    unsigned width;
+    unsigned height;
+    unsigned rowCount;
+
+    /**
+     * @brief The previous row, for the filters, and the row filtered with each filter.
+     *
+     */
+    std::vector<unsigned char> previousRow;
+    std::vector<unsigned char> filteredRows[5];
+
+    ZlibStream zlib;
+
+    void writeChunk(const char *type, const unsigned char *data, size_t size);
+
+    /**
+     * @brief Write the compressed data as IDAT chunks.
+     *
+     * @param all false to only write full chunks
+     */
+    void flushData(bool all);
+
+public:
+    /**
+     * @brief Add the next row to the image.
+     *
+     * @param rgba the width pixels of the row, 4 bytes per pixel
+     */
+    void writeRow(const unsigned char *rgba);
+
+    /**
+     * @brief End the image. All its rows must have been written.
+     *
+     */
+    void close();
+
+    /**
+     * @brief Construct a new Png Stream Writer object and write the header of the image.
+     *
+     * @param filename the name of the file
+     * @param w the width of the image (in pixels)
+     * @param h the height of the image (in pixels)
+     */
+    explicit PngStreamWriter(const std::string &filename, unsigned w, unsigned h);
+};
@@ -10,6 +10,10 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+
+#include <glm/geometric.hpp>
 #include <glm/vec3.hpp>
 
 #include "utils.hpp"
@@ -32,12 +36,35 @@ protected:
      */
     glm::vec3 dir;
 
+    /**
+     * @brief The componentwise inverse of the direction, and whether each component of the
+     * direction is negative (1) or not (0), computed once per ray for the slab tests against the
+     * boxes.
+     *
+     */
+    glm::vec3 invDir;
+    int sign[3];
+
     /**
      * @brief The color of the ray. Each element of the vec3 is contained in [0, 1].
      *
      */
     glm::vec3 color;
 
+    /**
+     * @brief The width of the beam of the ray at its origin: a ray traced through a pixel stands
+     * for a cone covering the pixel, whose width is used to filter the textures.
+     *
+     */
+    float width;
+
+    /**
+     * @brief The growth of the width of the beam per unit of length along the ray, 0 for an
+     * infinitely thin ray.
+     *
+     */
+    float spread;
+
 public:
     /**
      * @brief Get the origin of the Ray
@@ -53,6 +80,23 @@ public:
      */
     glm::vec3 getDir() const { return this->dir; }
 
+    /**
+     * @brief Get the componentwise inverse of the direction of the ray, infinite along the axes
+     * to which the ray is parallel
+     *
+     * @return glm::vec3
+     */
+    glm::vec3 getInvDir() const { return this->invDir; }
+
+    /**
+     * @brief Tells whether the direction of the ray is negative along an axis, a -0 component
+     * counting as negative
+     *
+     * @param axis 0, 1 or 2 for x, y or z
+     * @return int 1 if the inverse of the component is negative, 0 otherwise
+     */
+    int getSign(int axis) const { return this->sign[axis]; }
+
     /**
      * @brief Get the color of the ray (mainly of the source)
      *
@@ -72,7 +116,10 @@ public:
      *
      * @param dir the vector of the direction
      */
-    void setDir(glm::vec3 dir) { this->dir = dir; }
+    void setDir(glm::vec3 dir) {
+        this->dir = dir;
+        updateInverse();
+    }
 
     /**
      * @brief Set the color of the ray
@@ -81,6 +128,44 @@ public:
      */
     void setColor(glm::vec3 color) { this->color = color; }
 
+    /**
+     * @brief Get the Spread object
+     *
+     * @return float the growth of the width of the beam per unit of length
+     */
+    float getSpread() const { return this->spread; }
+
+    /**
+     * @brief Set the beam of the ray
+     *
+     * @param w the width of the beam at the origin
+     * @param s the growth of the width per unit of length
+     */
+    void setBeam(const float &w, const float &s) {
+        this->width = w;
+        this->spread = s;
+    }
+
+    /**
+     * @brief The width of the beam at some distance
+     *
+     * @param t the distance along the ray
+     * @return float
+     */
+    float getWidth(const float &t) const { return width + spread * t; }
+
+    /**
+     * @brief The width of the area of a surface covered by the beam, stretched when the surface is
+     * seen at a grazing angle
+     *
+     * @param t the distance of the surface along the ray
+     * @param normal the normal of the surface
+     * @return float
+     */
+    float getFootprint(const float &t, const glm::vec3 &normal) const {
+        return getWidth(t) / std::max(std::abs(glm::dot(dir, normal)), 0.01f);
+    }
+
     /**
      * @brief Move slightly the origin of the ray in the direction of the normal to avoid acne
      *
@@ -89,13 +174,24 @@ public:
      */
     void biais(glm::vec3 hitNormal, float biaisCoeff) { initPt = initPt + hitNormal * biaisCoeff; }
 
+    /**
+     * @brief Compute the inverse of the direction and its signs, after the direction changed
+     *
+     */
+    void updateInverse() {
+        invDir = 1.0f / dir;
+        for (int axis = 0; axis < 3; ++axis) sign[axis] = invDir[axis] < 0;
+    }
+
     // Constructors
     /** The default constructor
     /**
      * @brief Construct a Ray starting at 0,0,0 and going towards increasing x.
      *
      */
-    Ray() : initPt(glm::vec3(0, 0, 0)), dir(glm::vec3(1, 0, 0)) {}
+    Ray() : initPt(glm::vec3(0, 0, 0)), dir(glm::vec3(1, 0, 0)), width(0), spread(0) {
+        updateInverse();
+    }
 
     /** The specialized constructor.
     /**
@@ -104,7 +200,10 @@ public:
     * @param initPt the origin of the ray
     * @param dir the direction of the ray
     */
-    Ray(glm::vec3 initPt, glm::vec3 dir) : initPt(initPt), dir(glm::normalize(dir)) {}
+    Ray(glm::vec3 initPt, glm::vec3 dir)
+        : initPt(initPt), dir(glm::normalize(dir)), width(0), spread(0) {
+        updateInverse();
+    }
 
     /**
      * @brief An overload of the operator << to print rays for debug.
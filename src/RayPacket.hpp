@@ -0,0 +1,154 @@
+/**
+ * @file RayPacket.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Packets of coherent rays stored as structures of arrays, so that the intersection
+ * kernels process all the rays of a packet with the SIMD instructions of the target.
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <glm/vec3.hpp>
+
+#include "Ray.hpp"
+
+/**
+ * @brief The number of rays of a packet, which matches the width of the SIMD registers of the
+ * target: 16 floats with AVX-512, 8 with AVX/AVX2 and 4 with SSE.
+ *
+ */
+#if defined(__AVX512F__)
+#define RAY_PACKET_WIDTH 16
+#elif defined(__AVX__)
+#define RAY_PACKET_WIDTH 8
+#else
+#define RAY_PACKET_WIDTH 4
+#endif
+
+/**
+ * @brief A packet of rays, each coordinate being stored in its own aligned array. The lanes
+ * beyond size are inactive: they duplicate the first ray and their tMax is -INFINITY, so that
+ * they never hit anything.
+ * @class RayPacket
+ */
+struct alignas(64) RayPacket {
+    static constexpr unsigned WIDTH = RAY_PACKET_WIDTH;
+
+    float ox[WIDTH];
+    float oy[WIDTH];
+    float oz[WIDTH];
+    float dx[WIDTH];
+    float dy[WIDTH];
+    float dz[WIDTH];
+    float invDx[WIDTH];
+    float invDy[WIDTH];
+    float invDz[WIDTH];
+
+    /**
+     * @brief The number of active lanes.
+     *
+     */
+    unsigned size;
+
+    /**
+     * @brief Fill the packet with rays
+     *
+     * @param rays the rays of the active lanes
+     * @param count the number of rays, at most WIDTH
+     */
+    void set(const Ray *rays, unsigned count) {
+        size = count;
+        for (unsigned lane = 0; lane < WIDTH; ++lane) {
+            const Ray &ray = rays[lane < count ? lane : 0];
+            const glm::vec3 origin = ray.getInitPt();
+            const glm::vec3 dir = ray.getDir();
+            const glm::vec3 invDir = ray.getInvDir();
+            ox[lane] = origin.x;
+            oy[lane] = origin.y;
+            oz[lane] = origin.z;
+            dx[lane] = dir.x;
+            dy[lane] = dir.y;
+            dz[lane] = dir.z;
+            invDx[lane] = invDir.x;
+            invDy[lane] = invDir.y;
+            invDz[lane] = invDir.z;
+        }
+    }
+};
+
+/**
+ * @brief The closest hits found so far for the rays of a packet. t is also the bound of the
+ * queries: a lane only accepts hits closer than its t.
+ * @class PacketHit
+ */
+struct alignas(64) PacketHit {
+    float t[RayPacket::WIDTH];
+    unsigned primId[RayPacket::WIDTH];
+
+    /**
+     * @brief Index of the hit object in the scene, or of the hit triangle in a mesh, used to break
+     * the ties. Equals noHit when nothing has been hit.
+     *
+     */
+    unsigned id[RayPacket::WIDTH];
+
+    static constexpr unsigned noHit = ~0u;
+
+    /**
+     * @brief Reset the lanes: the active ones accept any hit, the inactive ones none.
+     *
+     * @param size the number of active lanes
+     */
+    void reset(unsigned size) {
+        for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+            t[lane] = lane < size ? INFINITY : -INFINITY;
+            primId[lane] = 0;
+            id[lane] = noHit;
+        }
+    }
+
+    /**
+     * @brief Keep the hits of candidate which are closer than the current ones. On equal
+     * distances the lowest id wins, so that the result does not depend on the order in which the
+     * candidates are tested. The candidate must only contain hits at distances lower or equal to
+     * the current ones.
+     *
+     * @param candidate the hits of a primitive, whose id is given
+     * @param candidateId the id of the primitive
+     */
+    void merge(const PacketHit &candidate, unsigned candidateId) {
+#pragma omp simd
+        for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+            bool closer = candidate.id[lane] != noHit &&
+                          (candidate.t[lane] < t[lane] ||
+                           (id[lane] != noHit && candidateId < id[lane]));
+            t[lane] = closer ? candidate.t[lane] : t[lane];
+            primId[lane] = closer ? candidate.primId[lane] : primId[lane];
+            id[lane] = closer ? candidateId : id[lane];
+        }
+    }
+
+    /**
+     * @brief Prepare the query of a single primitive: the same bounds, the lanes being inclusive
+     * so that merge can apply the tie-break, and no hit yet.
+     *
+     * @param current the closest hits found so far
+     */
+    void boundBy(const PacketHit &current) {
+        for (unsigned lane = 0; lane < RayPacket::WIDTH; ++lane) {
+            // std::nextafter(t, INFINITY) for the distances, the infinite bounds being kept
+            float bound = current.t[lane];
+            uint32_t bits;
+            std::memcpy(&bits, &bound, sizeof(bits));
+            bits += bound >= 0 && bound < INFINITY;
+            std::memcpy(&t[lane], &bits, sizeof(bits));
+            id[lane] = noHit;
+        }
+    }
+};
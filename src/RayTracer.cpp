@@ -12,9 +12,46 @@
 #include "RayTracer.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
 
 #include <glm/gtc/constants.hpp>
 
+#include "HdrStreamWriter.hpp"
+#include "PngStreamWriter.hpp"
+
+thread_local RayCounters threadRayCounters;
+
+namespace {
+
+/**
+ * @brief The buffers of directLighting, kept per thread so that they are cleared rather than
+ * allocated again at each shading point.
+ *
+ */
+struct LightingScratch {
+    std::vector<Ray> shadowRays;
+    std::vector<float> maxDists;
+    std::vector<glm::vec3> contributions;
+    std::vector<Ray> lightRays;
+    std::vector<float> weights;
+    std::vector<char> blocked;
+};
+
+thread_local LightingScratch lightingScratch;
+
+}  // namespace
+
+void RayTracer::addThreadRayCounters() const {
+#pragma omp critical(rayCounters)
+    {
+        rayCounters.primary += threadRayCounters.primary;
+        rayCounters.secondary += threadRayCounters.secondary;
+        rayCounters.shadow += threadRayCounters.shadow;
+    }
+}
+
 float fresnel(Ray iRay, const glm::vec3 &normal, const float &refractionIndex) {
     float kr;  // quantity of reflexion to be computed
 
@@ -61,211 +98,467 @@ glm::vec3 refract(const Ray &iRay, const glm::vec3 &normal, const float &refract
     return k < 0 ? glm::vec3() : iRay.getDir() * eta + n * (eta * cosi - sqrtf(k));
 }
 
-glm::vec3 castRay(Ray const &ray, std::shared_ptr<Light> const &lightSource,
-                  std::vector<std::shared_ptr<BasicObject>> const &objects,
-                  const glm::vec3 &backgroundColor, const int &depth, const int &maxDepth) {
-    glm::vec3 color = backgroundColor * 255.0f;
-    if (depth > maxDepth) {
-        return color;
-    } else {
-
-        std::vector<Ray> shadowRays;
-        Inter inter;
-        float closestDistance = INFINITY;
-
-        std::shared_ptr<BasicObject> hitObject = nullptr;
-
-        for (auto object : objects) {
-            object->intersect(ray, lightSource, inter, shadowRays);
+glm::vec3 directLighting(const Scene &scene, const Inter &inter, const glm::vec3 &intersectPt) {
+    const auto &sources = scene.getSources();
+    const glm::vec3 surfacePt = intersectPt + inter.normal * 0.00001f;
+
+    // Unshadowed contribution of each light
+    std::vector<Ray> &shadowRays = lightingScratch.shadowRays;
+    std::vector<float> &maxDists = lightingScratch.maxDists;
+    std::vector<glm::vec3> &contributions = lightingScratch.contributions;
+    std::vector<Ray> &lightRays = lightingScratch.lightRays;
+    shadowRays.clear();
+    maxDists.clear();
+    contributions.clear();
+    for (const auto &source : sources) {
+        lightRays.clear();
+        source->outboundRays(intersectPt, lightRays);
+        Ray shadowRay = lightRays[0];
+        shadowRay.biais(inter.normal, 0.00001f);
+        contributions.push_back(detail::mult(shadowRay.getColor(), inter.objColor) *
+                                (1 - inter.objReflexionIndex) * inter.objAlbedo /
+                                glm::pi<float>() *
+                                std::max(0.f, glm::dot(inter.normal, shadowRay.getDir())));
+        maxDists.push_back(glm::distance(surfacePt, source->pos));
+        shadowRays.push_back(shadowRay);
+    }
 
-            if (shadowRays.size() && inter.id < closestDistance) {
-                hitObject = object;
-                closestDistance = inter.id;
-            }
-            shadowRays.clear();
+    // Weight of each light in the sum: 1 when all the lights are used, the number of times the
+    // light is picked divided by its probability otherwise
+    std::vector<float> &weights = lightingScratch.weights;
+    weights.assign(sources.size(), 1);
+    const unsigned lightSamples = scene.getLightSamples();
+    if (lightSamples && lightSamples < sources.size()) {
+        float totalImportance = 0;
+        for (const auto &contribution : contributions) {
+            totalImportance += contribution.x + contribution.y + contribution.z;
         }
-        if (hitObject) {
-            // Calcul des rayons de diffusion
-            shadowRays.clear();
-            hitObject->intersect(ray, lightSource, inter, shadowRays);
-
-            shadowRays[0].biais(inter.normal, 0.00001f);
-
-            bool blocked = false;
-            float iDistance;  // distance with the intersection
-
-            std::vector<Ray> sRays;
-            glm::vec3 norm;
-
-            Inter blockedInter;
-            for (auto object : objects) {
-                object->intersect(shadowRays[0], lightSource, blockedInter, sRays);
-
-                // Si le rayon est obstrué avant la source lumineuse
-                if (sRays.size() && blockedInter.id < blockedInter.ld) {
-                    /*std::cout << *object << std::endl;
-                    std::cout << ray << std::endl
-                              << shadowRays[0] << std::endl
-                              << sRays[0] << std::endl
-                              << " - " << glm::distance(lightSource->pos, shadowRays[0].getInitPt())
-                              << " " << blockedInter.id << " " << blockedInter.ld << " "
-                              << blockedInter.normal << std::endl;*/
-                    blocked = true;
-                }
-                sRays.clear();
-            }
-            color = detail::mult(inter.rColor, inter.objColor) * (1 - inter.objReflexionIndex) *
-                    (float)(!blocked) * inter.objAlbedo / glm::pi<float>() *
-                    std::max(0.f, glm::dot(inter.normal, shadowRays[0].getDir()));
-            /*std::cout << *hitObject << hitObject->reflexionIndex<< std::endl;
-            std::cout << inter.rColor << " " << hitObject->color << " " << (float)(!blocked) << " "
-                      << hitObject->albedo << " " << (1 - hitObject->reflexionIndex) << " "
-                      << std::max(0.f, glm::dot(inter.normal, shadowRays[0].dir)) << " " << color
-                      << std::endl;*/
-            // std::cout << *hitObject/*->reflexionIndex*/ << std::endl;
-            if (inter.objReflexionIndex && !inter.objTransparency) {
-                Ray reflectedRay(
-                    shadowRays[0].getInitPt(),
-                    ray.getDir() - 2 * glm::dot(ray.getDir(), inter.normal) * inter.normal);
-             
-                color +=
-                    detail::mult(hitObject->color, castRay(reflectedRay, lightSource, objects,
-                                                           backgroundColor, depth + 1, maxDepth)) *
-                    hitObject->reflexionIndex;
+        std::fill(weights.begin(), weights.end(), 0.0f);
+        if (totalImportance > 0) {
+            // Deterministic random numbers seeded by the hit point, whatever the thread
+            uint32_t seed = 0;
+            for (int axis = 0; axis < 3; ++axis) {
+                uint32_t bits;
+                std::memcpy(&bits, &intersectPt[axis], sizeof(bits));
+                seed = detail::hash(seed ^ bits);
             }
-
-            if (inter.objTransparency) {
-                glm::vec3 refractionColor;
-                // compute fresnel
-                float kr = fresnel(ray, inter.normal, hitObject->refractiveIndex);
-                bool outside = glm::dot(ray.getDir(), inter.normal) < 0;
-                // compute refraction if it is not a case of total internal reflection
-                if (kr < 1) {
-                    Ray refractedRay = Ray(shadowRays[0].getInitPt(),
-                                           refract(ray, inter.normal, hitObject->refractiveIndex));
-                    outside ? refractedRay.biais(-inter.normal, 0.001f)
-                            : refractedRay.biais(+inter.normal, 0.001f);
-                    refractionColor = castRay(refractedRay, lightSource, objects, backgroundColor,
-                                              depth + 1, maxDepth);
+            for (unsigned sample = 0; sample < lightSamples; ++sample) {
+                float target = detail::toUnitFloat(detail::hash(seed + sample)) * totalImportance;
+                unsigned picked = 0;
+                float importance = 0;
+                for (; picked < sources.size(); ++picked) {
+                    importance = contributions[picked].x + contributions[picked].y +
+                                 contributions[picked].z;
+                    if (target < importance) break;
+                    target -= importance;
                 }
-
-                Ray reflectedRay =
-                    Ray(shadowRays[0].getInitPt(),
-                        ray.getDir() - 2 * glm::dot(ray.getDir(), inter.normal) * inter.normal);
-                outside ? reflectedRay.biais(+inter.normal, 0.00001f)
-                        : reflectedRay.biais(-inter.normal, 0.00001f);
-                glm::vec3 reflectionColor = castRay(reflectedRay, lightSource, objects,
-                                                    backgroundColor, depth + 1, maxDepth);
-
-                // mix the two
-                color +=
-                    reflectionColor * kr + refractionColor * (1 - kr) * hitObject->transparency;
+                // rounding errors may leave target slightly above the last importance
+                while (picked == sources.size() || importance <= 0) {
+                    --picked;
+                    importance = contributions[picked].x + contributions[picked].y +
+                                 contributions[picked].z;
+                }
+                weights[picked] += totalImportance / (importance * lightSamples);
             }
-        } else {  // If no intersection, set the color to the background color
-            color = backgroundColor * 255.0f;
         }
+    }
 
-        return color;
+    // The lights that do not contribute are not tested
+    std::vector<char> &blocked = lightingScratch.blocked;
+    blocked.resize(sources.size());
+    for (unsigned id = 0; id < sources.size(); ++id) {
+        blocked[id] = weights[id] == 0 || contributions[id] == glm::vec3(0, 0, 0);
     }
+    for (char lightBlocked : blocked) threadRayCounters.shadow += !lightBlocked;
+    scene.occluded(shadowRays, maxDists, blocked);
+
+    glm::vec3 color(0, 0, 0);
+    for (unsigned id = 0; id < sources.size(); ++id) {
+        if (!blocked[id]) color += contributions[id] * weights[id];
+    }
+    return color;
 }
 
-void StdRayTracer::render(const Scene &scene, const std::string& filename) const {
-    ImgHandler imgHandler;
+glm::vec3 shadeHit(Ray const &ray, const HitRecord &rec, const Scene &scene, const int &depth,
+                   const int &maxDepth) {
+    const BasicObject *hitObject = rec.object;
+    Inter inter;
+    hitObject->shade(ray, rec, inter);
+
+    glm::vec3 intersectPt = ray.getInitPt() + rec.t * ray.getDir();
+    glm::vec3 color = directLighting(scene, inter, intersectPt);
+    // Origin of the reflected and refracted rays, whose beams go on from the width reached at the
+    // hit, the surfaces being taken as flat
+    const glm::vec3 surfacePt = intersectPt + inter.normal * 0.00001f;
+    const float beamWidth = ray.getWidth(rec.t);
+
+    if (inter.objReflexionIndex && !inter.objTransparency) {
+        Ray reflectedRay(surfacePt,
+                         ray.getDir() - 2 * glm::dot(ray.getDir(), inter.normal) * inter.normal);
+        reflectedRay.setBeam(beamWidth, ray.getSpread());
+
+        color +=
+            detail::mult(hitObject->color, castRay(reflectedRay, scene, depth + 1, maxDepth)) *
+            hitObject->reflexionIndex;
+    }
+
+    if (inter.objTransparency) {
+        glm::vec3 refractionColor;
+        // compute fresnel
+        float kr = fresnel(ray, inter.normal, hitObject->refractiveIndex);
+        bool outside = glm::dot(ray.getDir(), inter.normal) < 0;
+        // compute refraction if it is not a case of total internal reflection
+        if (kr < 1) {
+            Ray refractedRay =
+                Ray(surfacePt, refract(ray, inter.normal, hitObject->refractiveIndex));
+            outside ? refractedRay.biais(-inter.normal, 0.001f)
+                    : refractedRay.biais(+inter.normal, 0.001f);
+            refractedRay.setBeam(beamWidth, ray.getSpread());
+            refractionColor = castRay(refractedRay, scene, depth + 1, maxDepth);
+        }
 
-    auto lightSources = scene.getSources()[0];
-    auto objects = scene.getObjects();
-    auto camera = scene.getCamera();
+        Ray reflectedRay =
+            Ray(surfacePt, ray.getDir() - 2 * glm::dot(ray.getDir(), inter.normal) * inter.normal);
+        outside ? reflectedRay.biais(+inter.normal, 0.00001f)
+                : reflectedRay.biais(-inter.normal, 0.00001f);
+        reflectedRay.setBeam(beamWidth, ray.getSpread());
+        glm::vec3 reflectionColor = castRay(reflectedRay, scene, depth + 1, maxDepth);
 
-    std::vector<unsigned char> image;
-    glm::vec3 color;
+        // mix the two
+        color += reflectionColor * kr + refractionColor * (1 - kr) * hitObject->transparency;
+    }
 
-    for (unsigned x = 0; x < camera->resX; ++x) {
-        for (unsigned y = 0; y < camera->resY; ++y) {
-            int depth = 0;
-            Ray primRay = camera->genRay(x, y);
+    return color;
+}
 
-            color = castRay(primRay, lightSources, objects, scene.getBackgroundColor(), depth,
-                            this->getMaxDepth());
-            std::vector<unsigned char> colorVec{(unsigned char)color[0], (unsigned char)color[1],
-                                                (unsigned char)color[2], (unsigned char)255};
-            image.insert(image.end(), colorVec.begin(), colorVec.end());
-        }
+glm::vec3 castRay(Ray const &ray, const Scene &scene, const int &depth, const int &maxDepth) {
+    if (depth > maxDepth) return scene.getBackgroundColor() * 255.0f;
+    if (depth > 0) {
+        ++threadRayCounters.secondary;
+    } else {
+        ++threadRayCounters.primary;
     }
 
-    imgHandler.writePNG(filename, image, camera->resX, camera->resY);
+    HitRecord rec;
+    if (!scene.hit(ray, INFINITY, rec)) {
+        // If no intersection, set the color to the background color
+        return scene.getBackgroundColor() * 255.0f;
+    }
+    return shadeHit(ray, rec, scene, depth, maxDepth);
 }
 
-void FixedAntiAliasingRayTracer::render(const Scene &scene, const std::string& filename) const {
-    ImgHandler imgHandler;
+void RayTracer::tracePrimaryRays(const Scene &scene, const std::vector<Ray> &rays,
+                                 std::vector<glm::vec3> &colors) const {
+    colors.resize(rays.size());
+    if (!packetTracing || maxDepth < 0) {
+        for (unsigned id = 0; id < rays.size(); ++id) {
+            colors[id] = castRay(rays[id], scene, 0, maxDepth);
+        }
+        return;
+    }
 
-    int sqrtAAPower = this->getAAPower();
-    float d = 1.0 / sqrtAAPower;
+    threadRayCounters.primary += rays.size();
+    RayPacket packet;
+    HitRecord recs[RayPacket::WIDTH];
+    for (unsigned first = 0; first < rays.size(); first += RayPacket::WIDTH) {
+        unsigned count = std::min<unsigned>(RayPacket::WIDTH, rays.size() - first);
+        packet.set(&rays[first], count);
+        std::fill(recs, recs + count, HitRecord());
+        scene.hitPacket(packet, recs);
+
+        // The rest of the path of each ray is incoherent and traced alone
+        for (unsigned lane = 0; lane < count; ++lane) {
+            colors[first + lane] =
+                recs[lane].object ? shadeHit(rays[first + lane], recs[lane], scene, 0, maxDepth)
+                                  : scene.getBackgroundColor() * 255.0f;
+        }
+    }
+}
 
-    auto lightSources = scene.getSources()[0];
-    auto objects = scene.getObjects();
+void RayTracer::render(const Scene &scene, const std::string &filename) const {
     auto camera = scene.getCamera();
 
-    std::vector<unsigned char> image;
-
-    glm::vec3 color;
-    for (float x = 0; x < camera->resX; ++x) {
-        //std::cout << x << std::endl;
-        for (float y = 0; y < camera->resY; ++y) {
-            color = glm::vec3(0, 0, 0);
+    // The rows are encoded as soon as their band of tiles is rendered, so that only two bands are
+    // held in memory. The linear colors are written as they are to the float formats, while the
+    // PNG rows are tone mapped and compressed.
+    std::unique_ptr<HdrStreamWriter> hdrWriter;
+    std::unique_ptr<PngStreamWriter> pngWriter;
+    std::vector<float> radianceRow;
+    std::vector<uint32_t> row;
+    Framebuffer::RowSink sink;
+    if (HdrStreamWriter::isHdrFilename(filename)) {
+        hdrWriter = std::make_unique<HdrStreamWriter>(filename, camera->resY, camera->resX);
+        radianceRow.resize(3 * camera->resY);
+        sink = [&](const Framebuffer &rows, unsigned x) {
+            rows.getRadianceRow(x, radianceRow.data());
+            hdrWriter->writeRow(radianceRow.data());
+        };
+    } else {
+        pngWriter = std::make_unique<PngStreamWriter>(filename, camera->resY, camera->resX);
+        row.resize(camera->resY);
+        sink = [&](const Framebuffer &rows, unsigned x) {
+            if (adaptation) {
+                toneMapper.mapRow(rows, x, row.data());
+            } else {
+                rows.getRow(x, (unsigned char *)row.data());
+            }
+            pngWriter->writeRow((const unsigned char *)row.data());
+        };
+    }
 
-            for (int idRayV = 1; idRayV < sqrtAAPower + 1; ++idRayV) {
-                for (int idRayH = 1; idRayH < sqrtAAPower + 1; ++idRayH) {
-                    int depth = 0;
-                    Ray primRay = camera->genRay(x + d * idRayH, y + d * idRayV);
-                    color = color + castRay(primRay, lightSources, objects, scene.getBackgroundColor(), depth,
-                                            this->getMaxDepth());
-                }
+    if (pngWriter && adaptation && toneMapper.needsWholeImage()) {
+        // The exposure depends on all the pixels: the image is rendered whole, then its rows are
+        // mapped in parallel by blocks
+        Framebuffer image(camera->resX, camera->resY);
+        renderFramebuffer(scene, image);
+        toneMapper.adaptExposure(image);
+
+        const unsigned blockRows = 64;
+        const unsigned rowSize = camera->resY;
+        std::vector<uint32_t> block(blockRows * rowSize);
+        for (unsigned xBegin = 0; xBegin < camera->resX; xBegin += blockRows) {
+            const int xEnd = std::min(xBegin + blockRows, camera->resX);
+#pragma omp parallel for
+            for (int x = xBegin; x < xEnd; ++x) {
+                toneMapper.mapRow(image, x, &block[(x - xBegin) * rowSize]);
+            }
+            for (int x = xBegin; x < xEnd; ++x) {
+                pngWriter->writeRow((const unsigned char *)&block[(x - xBegin) * rowSize]);
             }
-            color = color / ((float)(sqrtAAPower * sqrtAAPower));
-            std::vector<unsigned char> colorVec{(unsigned char)color[0], (unsigned char)color[1],
-                                                (unsigned char)color[2], (unsigned char)255};
-            image.insert(image.end(), colorVec.begin(), colorVec.end());
         }
+    } else {
+        // Several bands of tiles are held, so that they are rendered at once by the threads
+        Framebuffer framebuffer(camera->resX, camera->resY, STREAMED_BANDS * tileSize, sink);
+        renderFramebuffer(scene, framebuffer);
     }
 
-    imgHandler.writePNG(filename, image, camera->resX, camera->resY);
+    if (hdrWriter) {
+        hdrWriter->close();
+    } else {
+        pngWriter->close();
+    }
 }
 
-// A finir :(
-/*void StochasticAntiAliasingRayTracer::render(Scene scene, std::string filename) {
+void StdRayTracer::renderFramebuffer(const Scene &scene, Framebuffer &framebuffer) const {
+    auto camera = scene.getCamera();
+
+    auto renderTile = [&](const Tile &tile) {
+        std::vector<Ray> primRays;
+        std::vector<glm::vec3> colors;
+        for (unsigned x = tile.xBegin; x < tile.xEnd; ++x) {
+            for (unsigned y = tile.yBegin; y < tile.yEnd; ++y) {
+                primRays.push_back(camera->genRay(x, y));
+            }
+        }
+        tracePrimaryRays(scene, primRays, colors);
+
+        unsigned rayId = 0;
+        for (unsigned x = tile.xBegin; x < tile.xEnd; ++x) {
+            for (unsigned y = tile.yBegin; y < tile.yEnd; ++y) {
+                framebuffer.set(x, y, colors[rayId++]);
+            }
+        }
+    };
+
+    renderTiles(*camera, framebuffer, renderTile);
+}
+
+void FixedAntiAliasingRayTracer::renderFramebuffer(const Scene &scene,
+                                                   Framebuffer &framebuffer) const {
     int sqrtAAPower = this->getAAPower();
     float d = 1.0 / sqrtAAPower;
 
-    auto lightSources = scene.getSources()[0];
-    auto objects = scene.getObjects();
     auto camera = scene.getCamera();
 
-    cv::Mat image(cv::Size(camera->resX, camera->resY), CV_8UC3);
-
-    glm::vec3 color;
-    for (float x = 0; x < camera->resX; ++x) {
-        std::cout << x << std::endl;
-        for (float y = 0; y < camera->resY; ++y) {
-            color = glm::vec3(0, 0, 0);
-            glm::vec3 tmp = glm::vec3(0, 0, 0);
-            for (int idRayV = 1; idRayV < sqrtAAPower + 1; ++idRayV) {
-                for (int idRayH = 1; idRayH < sqrtAAPower + 1; ++idRayH) {
-                    int depth = 0;
-                    Ray primRay = camera->genRay(x + d * idRayH, y + d * idRayV);
-                    tmp = castRay(primRay, lightSources, objects, scene.getColor(), depth);
-                    color = color + tmp;
-                    //std::cout << d << " " << x + d * (float)idRayH << primRay << " " << tmp << "
-";
+    auto renderTile = [&](const Tile &tile) {
+        // The rays of a pixel are consecutive, so that they share their packets
+        std::vector<Ray> primRays;
+        std::vector<glm::vec3> colors;
+        for (unsigned x = tile.xBegin; x < tile.xEnd; ++x) {
+            for (unsigned y = tile.yBegin; y < tile.yEnd; ++y) {
+                for (int idRayV = 1; idRayV < sqrtAAPower + 1; ++idRayV) {
+                    for (int idRayH = 1; idRayH < sqrtAAPower + 1; ++idRayH) {
+                        primRays.push_back(
+                            camera->genRay((float)x + d * idRayH, (float)y + d * idRayV));
+                    }
                 }
             }
+        }
+        tracePrimaryRays(scene, primRays, colors);
 
-            image.at<cv::Vec3b>(x, y) =
-                detail::glm2cv(color / ((float)(sqrtAAPower * sqrtAAPower)));
-            //std::cout << detail::glm2cv(color / ((float)(sqrtAAPower * sqrtAAPower))) <<
-std::endl;
+        unsigned rayId = 0;
+        for (unsigned x = tile.xBegin; x < tile.xEnd; ++x) {
+            for (unsigned y = tile.yBegin; y < tile.yEnd; ++y) {
+                for (int idRay = 0; idRay < sqrtAAPower * sqrtAAPower; ++idRay) {
+                    framebuffer.accumulate(x, y, colors[rayId++]);
+                }
+            }
         }
+    };
+
+    renderTiles(*camera, framebuffer, renderTile);
+}
+
+void FxaaRayTracer::renderFramebuffer(const Scene &scene, Framebuffer &framebuffer) const {
+    Framebuffer image(framebuffer.getResX(), framebuffer.getResY());
+    StdRayTracer::renderFramebuffer(scene, image);
+    filter.apply(image, framebuffer);
+}
+
+glm::vec2 SuperSampler::offset(unsigned x, unsigned y, unsigned sampleId) const {
+    // Random shift of the pixel (Cranley-Patterson rotation)
+    uint32_t h = detail::hash(detail::hash(x ^ seed) ^ y);
+    float shiftX = detail::toUnitFloat(h);
+    float shiftY = detail::toUnitFloat(detail::hash(h));
+
+    // R2 sequence, from the plastic number
+    float u = shiftX + 0.7548776662f * sampleId;
+    float v = shiftY + 0.5698402910f * sampleId;
+    u -= std::floor(u);
+    v -= std::floor(v);
+    const float maxOffset = std::nextafter(1.0f, 0.0f);
+    return glm::vec2(std::min(u, maxOffset), std::min(v, maxOffset));
+}
+
+namespace {
+
+/**
+ * @brief The running sums of the luminances of the samples of a pixel.
+ *
+ */
+struct PixelSamples {
+    float lumSum = 0;
+    float lumSquareSum = 0;
+    unsigned count = 0;
+
+    void add(const glm::vec3 &color) {
+        float lum = 0.2126f * color[0] + 0.7152f * color[1] + 0.0722f * color[2];
+        lumSum += lum;
+        lumSquareSum += lum * lum;
+        ++count;
     }
-    cv::resize(image, image, cv::Size(1000, 1000));
-    cv::imwrite("RayTracing.png", image);
-    cv::imshow("RayTracing", image);
-}*/
\ No newline at end of file
+
+    float meanLuminance() const { return lumSum / count; }
+
+    /**
+     * @brief The standard error of the mean luminance, from the unbiased variance of the samples.
+     *
+     */
+    float standardError() const {
+        float variance = (lumSquareSum - lumSum * lumSum / count) / (count - 1);
+        return std::sqrt(std::max(0.0f, variance) / count);
+    }
+};
+
+}  // namespace
+
+void StochasticAntiAliasingRayTracer::renderFramebuffer(const Scene &scene,
+                                                        Framebuffer &framebuffer) const {
+    if (framebuffer.isStreamed()) {
+        // The edges are found on the first pass over the whole image: the image is rendered
+        // whole, then streamed
+        Framebuffer image(framebuffer.getResX(), framebuffer.getResY());
+        renderFramebuffer(scene, image);
+        for (unsigned x = 0; x < image.getResX(); ++x) {
+            for (unsigned y = 0; y < image.getResY(); ++y) framebuffer.set(x, y, image.get(x, y));
+            framebuffer.completeRows(x, x + 1);
+        }
+        return;
+    }
+
+    const SuperSampler sampler;
+
+    auto camera = scene.getCamera();
+    const unsigned resX = camera->resX;
+    const unsigned resY = camera->resY;
+    const unsigned firstSamples = std::max(2u, std::min(minSamples, maxSamples));
+
+    // Indexed as the pixels of the image, each tile updating its own pixels
+    std::vector<PixelSamples> pixels(camera->getNumberOfPixels());
+
+    // Add counts[i] samples to the pixel pixelIds[i]. The samples of a pixel are consecutive, so
+    // that they share their packets.
+    auto addSamples = [&](const std::vector<unsigned> &pixelIds,
+                          const std::vector<unsigned> &counts, std::vector<Ray> &primRays,
+                          std::vector<glm::vec3> &colors) {
+        primRays.clear();
+        for (unsigned id = 0; id < pixelIds.size(); ++id) {
+            unsigned pixelId = pixelIds[id];
+            unsigned x = pixelId / resY, y = pixelId % resY;
+            for (unsigned k = 0; k < counts[id]; ++k) {
+                glm::vec2 offset = sampler.offset(x, y, pixels[pixelId].count + k);
+                primRays.push_back(camera->genRay((float)x + offset.x, (float)y + offset.y));
+            }
+        }
+        tracePrimaryRays(scene, primRays, colors);
+
+        unsigned rayId = 0;
+        for (unsigned id = 0; id < pixelIds.size(); ++id) {
+            unsigned x = pixelIds[id] / resY, y = pixelIds[id] % resY;
+            for (unsigned k = 0; k < counts[id]; ++k) {
+                framebuffer.accumulate(x, y, colors[rayId]);
+                pixels[pixelIds[id]].add(colors[rayId++]);
+            }
+        }
+    };
+
+    // First pass: the same number of samples everywhere
+    forEachTile(*camera, [&](const Tile &tile) {
+        std::vector<unsigned> pixelIds;
+        std::vector<Ray> primRays;
+        std::vector<glm::vec3> colors;
+        for (unsigned x = tile.xBegin; x < tile.xEnd; ++x) {
+            for (unsigned y = tile.yBegin; y < tile.yEnd; ++y) {
+                pixelIds.push_back(framebuffer.index(x, y));
+            }
+        }
+        std::vector<unsigned> counts(pixelIds.size(), firstSamples);
+        addSamples(pixelIds, counts, primRays, colors);
+    });
+
+    // Copied, so that the edges do not depend on the refinement of the neighbouring tiles
+    std::vector<float> firstLuminances(pixels.size());
+    for (unsigned pixelId = 0; pixelId < pixels.size(); ++pixelId) {
+        firstLuminances[pixelId] = pixels[pixelId].meanLuminance();
+    }
+
+    // Refinement: batches of samples on the pixels which have not converged
+    forEachTile(*camera, [&](const Tile &tile) {
+        std::vector<unsigned> tilePixelIds;
+        std::vector<char> onEdge;
+        for (unsigned x = tile.xBegin; x < tile.xEnd; ++x) {
+            for (unsigned y = tile.yBegin; y < tile.yEnd; ++y) {
+                const float lum = firstLuminances[framebuffer.index(x, y)];
+                float contrast = 0;
+                auto compare = [&](unsigned neighbourId) {
+                    contrast = std::max(contrast, std::abs(lum - firstLuminances[neighbourId]));
+                };
+                if (x > 0) compare(framebuffer.index(x - 1, y));
+                if (x + 1 < resX) compare(framebuffer.index(x + 1, y));
+                if (y > 0) compare(framebuffer.index(x, y - 1));
+                if (y + 1 < resY) compare(framebuffer.index(x, y + 1));
+                tilePixelIds.push_back(framebuffer.index(x, y));
+                onEdge.push_back(contrast > edgeThreshold);
+            }
+        }
+
+        std::vector<unsigned> pixelIds, counts;
+        std::vector<Ray> primRays;
+        std::vector<glm::vec3> colors;
+        while (true) {
+            pixelIds.clear();
+            counts.clear();
+            for (unsigned id = 0; id < tilePixelIds.size(); ++id) {
+                const PixelSamples &samples = pixels[tilePixelIds[id]];
+                if (samples.count >= maxSamples) continue;
+                if ((onEdge[id] && samples.count < edgeSamples) ||
+                    samples.standardError() > threshold) {
+                    pixelIds.push_back(tilePixelIds[id]);
+                    counts.push_back(std::min(batchSize, maxSamples - samples.count));
+                }
+            }
+            if (pixelIds.empty()) break;
+            addSamples(pixelIds, counts, primRays, colors);
+        }
+    });
+}
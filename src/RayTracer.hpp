@@ -10,9 +10,39 @@
  */
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <exception>
+#include <thread>
+#include <vector>
 
+#include <glm/vec2.hpp>
+
+#include "Framebuffer.hpp"
+#include "FxaaFilter.hpp"
 #include "Scene.hpp"
+#include "ToneMapper.hpp"
+
+/**
+ * @brief The number of rays traced during a render, by kind.
+ *
+ */
+struct RayCounters {
+    unsigned long long primary = 0;
+    unsigned long long secondary = 0;  // reflected and refracted rays
+    unsigned long long shadow = 0;
+
+    unsigned long long total() const { return primary + secondary + shadow; }
+};
+
+/**
+ * @brief The rays traced by the current thread since the beginning of its tile. Kept per thread so
+ * that counting them does not synchronize the threads: they are added to the counters of the ray
+ * tracer at the end of each tile.
+ *
+ */
+extern thread_local RayCounters threadRayCounters;
 
 class RayTracer {
 protected:
@@ -23,17 +53,122 @@ protected:
      */
     bool adaptation;
 
+    /**
+     * @brief The adaptation of the colors to the 8 bits of the PNG files. It is mutable since its
+     * automatic exposure is computed by each render.
+     *
+     */
+    mutable ToneMapper toneMapper;
+
     /**
      * @brief The recursive maximum depth of the rays.
      *
      */
     int maxDepth;
 
+    /**
+     * @brief The size (in pixels) of the side of the tiles distributed among the threads.
+     *
+     */
+    unsigned tileSize;
+
+    /**
+     * @brief The number of bands of tiles held by a streamed framebuffer, and so rendered at once.
+     *
+     */
+    static constexpr unsigned STREAMED_BANDS = 8;
+
+    /**
+     * @brief Egals to true if the primary rays are traced by packets.
+     *
+     */
+    bool packetTracing;
+
+    /**
+     * @brief The rays traced by the renders since the last reset.
+     *
+     */
+    mutable RayCounters rayCounters;
+
+    /**
+     * @brief Trace primary rays (depth 0) and compute their colors. In packet mode the rays are
+     * grouped by RayPacket::WIDTH, in the given order, so consecutive rays should be coherent.
+     * The secondary rays are always traced one by one.
+     *
+     * @param scene the scene
+     * @param rays the primary rays
+     * @param colors the colors of the rays, resized to the number of rays
+     */
+    void tracePrimaryRays(const Scene &scene, const std::vector<Ray> &rays,
+                          std::vector<glm::vec3> &colors) const;
+
+    /**
+     * @brief Split the screen of the camera in tiles and render them in parallel. The tiles are
+     * handed out dynamically, so that the threads which finish early take the remaining tiles.
+     *
+     * @param camera the camera of the scene
+     * @param renderTile the function rendering one Tile
+     */
+    template <typename TileRenderer>
+    void forEachTile(const Camera &camera, TileRenderer renderTile) const;
+
+    /**
+     * @brief Render the tiles in parallel like forEachTile, band of tiles after band of tiles for
+     * a streamed framebuffer. The tiles are still handed out dynamically, in the order of the
+     * bands: several bands are rendered at once, and the thread finishing the last tile of a band
+     * hands it to bandDone, as soon as the bands before it are done. A tile only starts when the
+     * band windowBands bands before its own is done, since they share the same rows of the window.
+     *
+     * @param camera the camera of the scene
+     * @param renderTile the function rendering one Tile
+     * @param windowBands the number of bands held by the framebuffer, at least 1
+     * @param bandDone the function called with the rows [xBegin, xEnd[ of each band, in order,
+     * never by two threads at once
+     */
+    template <typename TileRenderer, typename BandHandler>
+    void forEachTile(const Camera &camera, TileRenderer renderTile, unsigned windowBands,
+                     BandHandler bandDone) const;
+
+    /**
+     * @brief Render the tiles of a framebuffer: with forEachTile when it holds the whole image,
+     * and band by band when it is streamed, its complete rows being handed to its sink.
+     *
+     * @param camera the camera of the scene
+     * @param framebuffer the image
+     * @param renderTile the function rendering one Tile in the framebuffer
+     */
+    template <typename TileRenderer>
+    void renderTiles(const Camera &camera, Framebuffer &framebuffer,
+                     TileRenderer renderTile) const;
+
+    /**
+     * @brief The tile (tileX, tileY) of the screen, the tiles of the border being cut.
+     *
+     * @param camera the camera of the scene
+     * @param tileX the band of the tile
+     * @param tileY the index of the tile in the band
+     * @return Tile
+     */
+    Tile getTile(const Camera &camera, unsigned tileX, unsigned tileY) const {
+        Tile tile;
+        tile.xBegin = tileX * tileSize;
+        tile.xEnd = std::min(tile.xBegin + tileSize, camera.resX);
+        tile.yBegin = tileY * tileSize;
+        tile.yEnd = std::min(tile.yBegin + tileSize, camera.resY);
+        return tile;
+    }
+
+    /**
+     * @brief Add the rays traced by the current thread to the counters of the ray tracer.
+     *
+     */
+    void addThreadRayCounters() const;
+
 public:
     /**
      * @brief Get the Adaptation object
      *
-     * @return true to adapt the sensitivity
+     * @return true to adapt the luminosity with the tone mapper
      * @return false to keep overflown colors
      */
     bool getAdaptation() const { return this->adaptation; }
@@ -53,31 +188,84 @@ public:
     void setMaxDepth(const int &max) { this->maxDepth = max; }
 
     /**
-     * @brief Correction of color overflows
+     * @brief Get the size of the tiles
      *
-     * @param image the pixels of the image
+     * @return unsigned
      */
+    unsigned getTileSize() const { return this->tileSize; }
 
-    /*void adaptLuminosity(std::vector<unsigned char> &image) const {
-        for (auto channelPixel : image) {
-            channelPixel = std::min(channelPixel, (unsigned char)255);
-        }
-    }*/
+    /**
+     * @brief Set the size of the tiles
+     *
+     * @param size the side of the tiles in pixels
+     */
+    void setTileSize(const unsigned &size) { this->tileSize = std::max(1u, size); }
+
+    /**
+     * @brief Get the Packet Tracing object
+     *
+     * @return true if the primary rays are traced by packets
+     */
+    bool getPacketTracing() const { return this->packetTracing; }
 
     /**
-     * @brief Pure virtual method - The main method of the ray tracer. Renders a 3D scene ans
-     * saves the image.
+     * @brief Set the Packet Tracing object. The images are the same in both modes up to the rounding
+     * of the vectorized kernels, the packets being faster on coherent primary rays.
+     *
+     * @param packets true to trace the primary rays by packets
+     */
+    void setPacketTracing(const bool &packets) { this->packetTracing = packets; }
+
+    /**
+     * @brief Get the numbers of rays traced by the renders since the last reset
+     *
+     * @return RayCounters
+     */
+    RayCounters getRayCounters() const { return this->rayCounters; }
+
+    /**
+     * @brief Reset the numbers of rays traced
+     *
+     */
+    void resetRayCounters() { this->rayCounters = RayCounters(); }
+
+    /**
+     * @brief Get the Tone Mapper object
+     *
+     * @return const ToneMapper&
+     */
+    const ToneMapper &getToneMapper() const { return this->toneMapper; }
+
+    /**
+     * @brief Set the Tone Mapper object, used with the adaptation
+     *
+     * @param mapper the conversion of the colors to 8 bits
+     */
+    void setToneMapper(const ToneMapper &mapper) { this->toneMapper = mapper; }
+
+    /**
+     * @brief Pure virtual method - The main method of the ray tracer. Renders a 3D scene in a
+     * framebuffer.
+     *
+     * @param scene
+     * @param framebuffer the image, of the resolution of the camera, whose pixels have no sample
+     */
+    virtual void renderFramebuffer(const Scene &scene, Framebuffer &framebuffer) const = 0;
+
+    /**
+     * @brief Renders a 3D scene ans saves the image. The PNG images are adapted by the tone mapper
+     * if the adaptation is on, while the PFM and EXR images keep the linear colors.
      *
      * @param scene
-     * @param filename name of the PNG file
+     * @param filename name of the PNG, PFM or EXR file
      */
-    virtual void render(const Scene &scene, const std::string &filename) const = 0;
+    void render(const Scene &scene, const std::string &filename) const;
 
     /**
      * @brief Construct a new Ray Tracer object (default)
      *
      */
-    explicit RayTracer() : adaptation(true), maxDepth(3) {}
+    explicit RayTracer() : adaptation(true), maxDepth(3), tileSize(16), packetTracing(true) {}
 
     /**
      * @brief Construct a new Ray Tracer object
@@ -85,9 +273,74 @@ public:
      * @param adapt adaptation or not
      * @param max maxDepth of the rays
      */
-    explicit RayTracer(const bool &adapt, const int &max) : adaptation(adapt), maxDepth(max) {}
+    explicit RayTracer(const bool &adapt, const int &max)
+        : adaptation(adapt), maxDepth(max), tileSize(16), packetTracing(true) {}
 };
 
+template <typename TileRenderer>
+void RayTracer::forEachTile(const Camera &camera, TileRenderer renderTile) const {
+    const unsigned tilesX = (camera.resX + tileSize - 1) / tileSize;
+    const unsigned tilesY = (camera.resY + tileSize - 1) / tileSize;
+    const int tileCount = tilesX * tilesY;
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int tileId = 0; tileId < tileCount; ++tileId) {
+        threadRayCounters = RayCounters();
+        renderTile(getTile(camera, tileId / tilesY, tileId % tilesY));
+        addThreadRayCounters();
+    }
+}
+
+template <typename TileRenderer, typename BandHandler>
+void RayTracer::forEachTile(const Camera &camera, TileRenderer renderTile, unsigned windowBands,
+                            BandHandler bandDone) const {
+    const unsigned tilesX = (camera.resX + tileSize - 1) / tileSize;
+    const unsigned tilesY = (camera.resY + tileSize - 1) / tileSize;
+    const int tileCount = tilesX * tilesY;
+
+    // The tiles left in each band, and the first band not handed to bandDone yet
+    std::vector<std::atomic<unsigned>> remaining(tilesX);
+    for (auto &count : remaining) count.store(tilesY, std::memory_order_relaxed);
+    std::atomic<unsigned> doneBands(0);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int tileId = 0; tileId < tileCount; ++tileId) {
+        const unsigned band = tileId / tilesY;
+        // The tiles of the previous bands are all handed out, so that this wait always ends
+        while (band >= doneBands.load(std::memory_order_acquire) + windowBands) {
+            std::this_thread::yield();
+        }
+
+        threadRayCounters = RayCounters();
+        renderTile(getTile(camera, band, tileId % tilesY));
+        addThreadRayCounters();
+
+        if (remaining[band].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+#pragma omp critical(bandDone)
+            {
+                unsigned next = doneBands.load(std::memory_order_relaxed);
+                while (next < tilesX && remaining[next].load(std::memory_order_acquire) == 0) {
+                    bandDone(next * tileSize, std::min((next + 1) * tileSize, camera.resX));
+                    doneBands.store(++next, std::memory_order_release);
+                }
+            }
+        }
+    }
+}
+
+template <typename TileRenderer>
+void RayTracer::renderTiles(const Camera &camera, Framebuffer &framebuffer,
+                            TileRenderer renderTile) const {
+    if (!framebuffer.isStreamed()) {
+        forEachTile(camera, renderTile);
+        return;
+    }
+    const unsigned windowBands = std::max(1u, framebuffer.getWindowRows() / tileSize);
+    forEachTile(camera, renderTile, windowBands, [&](unsigned xBegin, unsigned xEnd) {
+        framebuffer.completeRows(xBegin, xEnd);
+    });
+}
+
 /**
  * @brief Standard ray tracer engine.
  *
@@ -95,11 +348,12 @@ public:
 class StdRayTracer : public RayTracer {
 public:
     /**
-     * @brief
+     * @brief Renders the scene with one ray per pixel.
      *
      * @param scene
+     * @param framebuffer the image
      */
-    void render(const Scene &scene, const std::string &filename) const override;
+    void renderFramebuffer(const Scene &scene, Framebuffer &framebuffer) const override;
 
     /**
      * @brief Construct a new Std Ray Tracer object
@@ -147,8 +401,9 @@ public:
      * @brief Renders the scene in 2D with Anti-Aliasing.
      *
      * @param scene
+     * @param framebuffer the image
      */
-    void render(const Scene &scene, const std::string &filename) const override;
+    void renderFramebuffer(const Scene &scene, Framebuffer &framebuffer) const override;
 
     /**
      * @brief Construct a new Fixed Anti Aliasing Ray Tracer and set its power to 4.
@@ -165,20 +420,214 @@ public:
         : RayTracer(adapt, max), sqrtAAPower(pow) {}
 };
 
-/*class StochasticAntiAliasingRayTracer {
+/**
+ * @brief Generates the positions of the samples inside the pixels. The k-th sample of a pixel
+ * follows the R2 low discrepancy sequence, shifted by a random offset drawn from the pixel
+ * coordinates: the first samples of a pixel are spread over its whole area whatever their number,
+ * and two renders of the same scene are identical.
+ *
+ */
+class SuperSampler {
 protected:
-    int minSteps;
+    /**
+     * @brief Seed of the offsets of the pixels.
+     *
+     */
+    uint32_t seed;
 
 public:
+    /**
+     * @brief Position of a sample in its pixel.
+     *
+     * @param x the row of the pixel
+     * @param y the column of the pixel
+     * @param sampleId the index of the sample in the pixel
+     * @return glm::vec2 the offset of the sample from the corner of the pixel, in [0, 1[^2
+     */
+    glm::vec2 offset(unsigned x, unsigned y, unsigned sampleId) const;
 
-    void render(Scene scene);
-};*/
+    /**
+     * @brief Construct a new Super Sampler object
+     *
+     * @param s the seed of the offsets of the pixels
+     */
+    explicit SuperSampler(uint32_t s = 0) : seed(s) {}
+};
 
 /**
- * @brief
+ * @brief Ray tracer engine with adaptive AntiAliasing. Every pixel first receives minSamples
+ * samples, then batches of samples are added to the pixels whose luminance is still uncertain or
+ * which lie on an edge, until they converge or reach maxSamples. The flat areas of the image are
+ * thus rendered with a few rays, the budget being spent on the edges and the noisy areas.
+ *
+ */
+class StochasticAntiAliasingRayTracer : public RayTracer {
+protected:
+    /**
+     * @brief The number of samples of every pixel.
+     *
+     */
+    unsigned minSamples;
+
+    /**
+     * @brief The maximum number of samples of a pixel.
+     *
+     */
+    unsigned maxSamples;
+
+    /**
+     * @brief The number of samples added at once to a pixel which has not converged.
+     *
+     */
+    unsigned batchSize;
+
+    /**
+     * @brief A pixel has converged when the standard error of its mean luminance is below this
+     * threshold, in levels of the 8 bits image.
+     *
+     */
+    float threshold;
+
+    /**
+     * @brief A pixel lies on an edge when its first mean luminance differs from the one of one of
+     * its neighbours by more than this threshold, in levels of the 8 bits image. The pixels on an
+     * edge receive at least edgeSamples samples, since their first samples may all miss the edge.
+     *
+     */
+    float edgeThreshold;
+    unsigned edgeSamples;
+
+public:
+    /**
+     * @brief Get the Min Samples object
+     *
+     * @return unsigned
+     */
+    unsigned getMinSamples() const { return this->minSamples; }
+
+    /**
+     * @brief Set the Min Samples object
+     *
+     * @param samples the number of samples of every pixel, at least 2 to estimate the variance
+     */
+    void setMinSamples(const unsigned &samples) { this->minSamples = std::max(2u, samples); }
+
+    /**
+     * @brief Get the Max Samples object
+     *
+     * @return unsigned
+     */
+    unsigned getMaxSamples() const { return this->maxSamples; }
+
+    /**
+     * @brief Set the Max Samples object
+     *
+     * @param samples the maximum number of samples of a pixel
+     */
+    void setMaxSamples(const unsigned &samples) { this->maxSamples = samples; }
+
+    /**
+     * @brief Get the Threshold object
+     *
+     * @return float
+     */
+    float getThreshold() const { return this->threshold; }
+
+    /**
+     * @brief Set the Threshold object
+     *
+     * @param t the standard error below which a pixel has converged
+     */
+    void setThreshold(const float &t) { this->threshold = t; }
+
+    /**
+     * @brief Renders the scene in 2D with adaptive Anti-Aliasing.
+     *
+     * @param scene
+     * @param framebuffer the image
+     */
+    void renderFramebuffer(const Scene &scene, Framebuffer &framebuffer) const override;
+
+    /**
+     * @brief Construct a new Stochastic Anti Aliasing Ray Tracer object, with 4 to 64 samples per
+     * pixel.
+     *
+     */
+    explicit StochasticAntiAliasingRayTracer()
+        : minSamples(4),
+          maxSamples(64),
+          batchSize(4),
+          threshold(1.0f),
+          edgeThreshold(4.0f),
+          edgeSamples(16) {}
+
+    /**
+     * @brief Construct a new Stochastic Anti Aliasing Ray Tracer object
+     *
+     * @param adapt adaptation or not
+     * @param max maxDepth of the rays
+     * @param samples the maximum number of samples of a pixel
+     */
+    explicit StochasticAntiAliasingRayTracer(const bool &adapt, const int &max,
+                                             const unsigned &samples)
+        : RayTracer(adapt, max),
+          minSamples(4),
+          maxSamples(samples),
+          batchSize(4),
+          threshold(1.0f),
+          edgeThreshold(4.0f),
+          edgeSamples(16) {}
+};
+
+/**
+ * @brief Ray tracer engine with a post-process anti-aliasing: the scene is rendered with one ray
+ * per pixel, as by the standard engine, then its edges are smoothed by the FXAA filter. The edges
+ * are much better than without anti-aliasing for almost the cost of the standard engine, though
+ * the details smaller than a pixel are not recovered as with more rays.
  *
  */
-class SuperSampler {};
+class FxaaRayTracer : public StdRayTracer {
+protected:
+    FxaaFilter filter;
+
+public:
+    /**
+     * @brief Get the Filter object
+     *
+     * @return const FxaaFilter&
+     */
+    const FxaaFilter &getFilter() const { return this->filter; }
+
+    /**
+     * @brief Set the Filter object
+     *
+     * @param fxaa the settings of the filter
+     */
+    void setFilter(const FxaaFilter &fxaa) { this->filter = fxaa; }
+
+    /**
+     * @brief Renders the scene with one ray per pixel, then filters the image. The edges being
+     * followed over several rows, the image is rendered whole before it is filtered.
+     *
+     * @param scene
+     * @param framebuffer the image
+     */
+    void renderFramebuffer(const Scene &scene, Framebuffer &framebuffer) const override;
+
+    /**
+     * @brief Construct a new Fxaa Ray Tracer object
+     *
+     */
+    explicit FxaaRayTracer() : StdRayTracer() {}
+
+    /**
+     * @brief Construct a new Fxaa Ray Tracer object
+     *
+     * @param adapt adaptation or not
+     * @param max maxDepth of the rays
+     */
+    explicit FxaaRayTracer(const bool &adapt, const int &max) : StdRayTracer(adapt, max) {}
+};
 
 /**
  * @brief Fresnel function as explained here :
@@ -203,16 +652,38 @@ float fresnel(Ray iRay, const glm::vec3 &normal, const float &refractionIndex);
  */
 glm::vec3 refract(const Ray &iRay, const glm::vec3 &normal, const float &refractionIndex);
 
+/**
+ * @brief Diffuse lighting of a hit point by the light sources of the scene. The shadow rays
+ * towards all the lights are tested together. If the scene asks for fewer light samples than it
+ * has lights, the lights are picked randomly with a probability proportional to their unshadowed
+ * contribution, and weighted so that the result stays unbiased.
+ *
+ * @param scene the scene, which contains the lights and finds the objects blocking them
+ * @param inter the data about the intersection
+ * @param intersectPt the hit point
+ * @return glm::vec3
+ */
+glm::vec3 directLighting(const Scene &scene, const Inter &inter, const glm::vec3 &intersectPt);
+
+/**
+ * @brief Compute the color of a ray which hits an object: lighting, reflection and refraction.
+ *
+ * @param ray the incoming ray
+ * @param rec the closest hit of the ray
+ * @param scene the scene
+ * @param depth the depth of the ray
+ * @param maxDepth the maximum depth of the rays
+ * @return glm::vec3
+ */
+glm::vec3 shadeHit(Ray const &ray, const HitRecord &rec, const Scene &scene, const int &depth,
+                   const int &maxDepth);
+
 /**
  * @brief
  *
  * @param ray
- * @param lightSource
- * @param objects
- * @param backgroundColor
+ * @param scene the scene, which finds the objects hit by the rays and contains the lights
  * @param depth
  * @return glm::vec3
  */
-glm::vec3 castRay(Ray const &ray, std::shared_ptr<Light> const &lightSource,
-                  std::vector<std::shared_ptr<BasicObject>> const &objects,
-                  const glm::vec3 &backgroundColor, const int &depth, const int &maxDepth);
\ No newline at end of file
+glm::vec3 castRay(Ray const &ray, const Scene &scene, const int &depth, const int &maxDepth);
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ * @file Scene.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The queries of the rays against the objects of the scene.
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "Scene.hpp"
+
+void Scene::buildAccelerationStructure() {
+    std::vector<AABB> objectBounds;
+    boundedIds.clear();
+    unboundedIds.clear();
+    for (unsigned id = 0; id < objects.size(); ++id) {
+        if (objects[id]->isBounded()) {
+            boundedIds.push_back(id);
+            objectBounds.push_back(objects[id]->getBounds());
+        } else {
+            unboundedIds.push_back(id);
+        }
+    }
+    bvh.build(objectBounds);
+    accelerated = true;
+}
+
+bool Scene::hit(const Ray &iRay, float tMax, HitRecord &rec) const {
+    float closestDistance = tMax;
+    unsigned closestId = objects.size();
+    HitRecord recTemp;
+
+    // Keep the closest hit, the first object in the scene winning the ties
+    auto testObject = [&](unsigned id, float &tClosest) {
+        if (objects[id]->hit(iRay, std::nextafter(tClosest, INFINITY), recTemp) &&
+            (recTemp.t < tClosest || (closestId < objects.size() && id < closestId))) {
+            tClosest = recTemp.t;
+            closestId = id;
+            rec = recTemp;
+        }
+    };
+
+    if (accelerated) {
+        for (unsigned id : unboundedIds) testObject(id, closestDistance);
+        bvh.traverse(iRay, closestDistance, [&](unsigned primId, float &tClosest) {
+            testObject(boundedIds[primId], tClosest);
+        });
+    } else {
+        for (unsigned id = 0; id < objects.size(); ++id) testObject(id, closestDistance);
+    }
+
+    if (closestId == objects.size()) return false;
+    rec.object = objects[closestId]->getHitObject(rec.primId);
+    return true;
+}
+
+bool Scene::hitPacket(const RayPacket &packet, HitRecord *recs) const {
+    PacketHit closest;
+    closest.reset(packet.size);
+    PacketHit candidate;
+
+    // Keep the closest hits, the first object in the scene winning the ties
+    auto testObject = [&](unsigned id) {
+        candidate.boundBy(closest);
+        objects[id]->hitPacket(packet, candidate);
+        closest.merge(candidate, id);
+    };
+
+    if (accelerated) {
+        for (unsigned id : unboundedIds) testObject(id);
+        bvh.traversePacket(packet, closest.t,
+                           [&](unsigned primId) { testObject(boundedIds[primId]); });
+    } else {
+        for (unsigned id = 0; id < objects.size(); ++id) testObject(id);
+    }
+
+    bool found = false;
+    for (unsigned lane = 0; lane < packet.size; ++lane) {
+        if (closest.id[lane] == PacketHit::noHit) continue;
+        recs[lane].t = closest.t[lane];
+        recs[lane].primId = closest.primId[lane];
+        recs[lane].object = objects[closest.id[lane]]->getHitObject(closest.primId[lane]);
+        found = true;
+    }
+    return found;
+}
+
+bool Scene::occluded(const Ray &iRay, float maxDist) const {
+    if (!accelerated) {
+        for (const auto &object : objects) {
+            if (object->occluded(iRay, maxDist)) return true;
+        }
+        return false;
+    }
+
+    for (unsigned id : unboundedIds) {
+        if (objects[id]->occluded(iRay, maxDist)) return true;
+    }
+    return bvh.traverseAny(iRay, maxDist, [&](unsigned primId) {
+        return objects[boundedIds[primId]]->occluded(iRay, maxDist);
+    });
+}
+
+void Scene::occluded(const std::vector<Ray> &rays, const std::vector<float> &maxDists,
+                     std::vector<char> &blocked) const {
+    for (unsigned rayId = 0; rayId < rays.size(); ++rayId) {
+        if (blocked[rayId]) continue;
+        if (!accelerated) {
+            blocked[rayId] = occluded(rays[rayId], maxDists[rayId]);
+            continue;
+        }
+        for (unsigned id : unboundedIds) {
+            if (objects[id]->occluded(rays[rayId], maxDists[rayId])) {
+                blocked[rayId] = true;
+                break;
+            }
+        }
+    }
+
+    if (accelerated) {
+        bvh.traverseAnyBatch(rays, maxDists, blocked, [&](unsigned primId, unsigned rayId) {
+            return objects[boundedIds[primId]]->occluded(rays[rayId], maxDists[rayId]);
+        });
+    }
+}
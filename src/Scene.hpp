@@ -15,6 +15,7 @@
 #include <memory>
 #include <vector>
 
+#include "BVH.hpp"
 #include "Object/BasicObject.hpp"
 #include "Object/Camera.hpp"
 
@@ -30,6 +31,30 @@ class Scene {
      */
     std::vector<std::shared_ptr<BasicObject>> objects;
 
+    /**
+     * @brief The top-level acceleration structure over the bounded objects of the scene
+     *
+     */
+    BVH bvh;
+
+    /**
+     * @brief The ids in objects of the primitives of the BVH
+     *
+     */
+    std::vector<unsigned> boundedIds;
+
+    /**
+     * @brief The ids in objects of the infinite objects (planes), tested against every ray
+     *
+     */
+    std::vector<unsigned> unboundedIds;
+
+    /**
+     * @brief Egals to true if the acceleration structure is up to date with the objects.
+     *
+     */
+    bool accelerated;
+
     /**
      * @brief The sources of light contained in the scene
      *
@@ -54,6 +79,12 @@ class Scene {
      */
     int maxDepth;
 
+    /**
+     * @brief The number of lights sampled at each hit point, 0 to shade with every light.
+     *
+     */
+    unsigned lightSamples;
+
 public:
     /**
      * @brief Get the Background Color of the scene
@@ -78,6 +109,22 @@ public:
 
     void setMaxDepth(int depth) { this->maxDepth = depth; }
 
+    /**
+     * @brief Get the number of lights sampled at each hit point
+     *
+     * @return unsigned 0 if every light is used
+     */
+    unsigned getLightSamples() const { return lightSamples; }
+
+    /**
+     * @brief Set the number of lights sampled at each hit point. When the scene contains more
+     * lights, they are picked with a probability proportional to their contribution, which bounds
+     * the cost of the shading whatever the number of lights.
+     *
+     * @param samples the number of lights per hit point, 0 to use every light
+     */
+    void setLightSamples(unsigned samples) { this->lightSamples = samples; }
+
     /**
      * @brief Get the pointers of the objects of the scene
      *
@@ -91,7 +138,7 @@ public:
      *
      * @return std::shared_ptr<LightSource>
      */
-    auto getSources() const { return sources; }
+    const std::vector<std::shared_ptr<Light>> &getSources() const { return sources; }
 
     /**
      * @brief Get a pointer of the camera of the scene
@@ -105,7 +152,61 @@ public:
      *
      * @param object
      */
-    void addObject(const std::shared_ptr<BasicObject> &object) { objects.push_back(object); }
+    void addObject(const std::shared_ptr<BasicObject> &object) {
+        objects.push_back(object);
+        accelerated = false;
+    }
+
+    /**
+     * @brief Build the acceleration structure over the objects of the scene. Must be called again
+     * after adding objects, otherwise the scene falls back on testing every object.
+     *
+     */
+    void buildAccelerationStructure();
+
+    /**
+     * @brief Find the closest object hit by a ray. Only the distance is computed: the normal and
+     * the material are left to the shade method of rec.object.
+     *
+     * @param iRay the incoming ray
+     * @param tMax the intersections at tMax or further are ignored
+     * @param rec the hit record of the closest intersection, modified only if there is a hit
+     * @return true if an object is hit closer than tMax
+     */
+    bool hit(const Ray &iRay, float tMax, HitRecord &rec) const;
+
+    /**
+     * @brief Find the closest objects hit by a packet of coherent rays, walking through the
+     * acceleration structure once for the whole packet.
+     *
+     * @param packet the incoming rays
+     * @param recs the hit records of the rays of the packet, modified only for the rays hitting
+     * an object
+     * @return true if at least one ray hits an object
+     */
+    bool hitPacket(const RayPacket &packet, HitRecord *recs) const;
+
+    /**
+     * @brief Tells whether any object blocks a ray before maxDist. Stops at the first blocking
+     * object found, so this is the query to use for the shadow rays.
+     *
+     * @param iRay the incoming ray
+     * @param maxDist the intersections at maxDist or further do not block the ray
+     * @return true if an object is hit closer than maxDist
+     */
+    bool occluded(const Ray &iRay, float maxDist) const;
+
+    /**
+     * @brief Occlusion query of several rays sharing a single walk through the acceleration
+     * structure, used for the shadow rays of one hit point towards several lights.
+     *
+     * @param rays the incoming rays
+     * @param maxDists the intersections at maxDists[rayId] or further do not block the ray rayId
+     * @param blocked set to true for the blocked rays. The rays already blocked when calling are
+     * not tested, which allows to skip the lights that do not contribute.
+     */
+    void occluded(const std::vector<Ray> &rays, const std::vector<float> &maxDists,
+                  std::vector<char> &blocked) const;
 
     /**
      * @brief Add a light source to the scene
@@ -127,7 +228,8 @@ public:
     default)
      *
      */
-    explicit Scene() : backgroundColor(glm::vec3(0, 0, 0)) {}
+    explicit Scene()
+        : accelerated(false), backgroundColor(glm::vec3(0, 0, 0)), lightSamples(0) {}
 
     /** A specialized constructor.
     /**
@@ -135,5 +237,6 @@ public:
      *
      * @param color
      */
-    explicit Scene(glm::vec3 color) : backgroundColor(color) {}
+    explicit Scene(glm::vec3 color)
+        : accelerated(false), backgroundColor(color), lightSamples(0) {}
 };
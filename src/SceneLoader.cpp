@@ -0,0 +1,67 @@
+/**
+ * @file SceneLoader.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Build the scenes rendered by the executables
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "SceneLoader.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+#include "MeshCache.hpp"
+#include "Parser.hpp"
+#include "Object/TriangleMesh.hpp"
+#include "Object/DirectLight.hpp"
+
+Scene loadScene(const std::string &filename) {
+    Scene scene;
+
+    std::ifstream ifs(filename);
+
+    if (!ifs.is_open()) {
+        throw std::runtime_error(
+            "The file representing your scene does not exist. Please check the path to your file ");
+    } else {
+        std::string xmlData((std::istreambuf_iterator<char>(ifs)),
+                            (std::istreambuf_iterator<char>()));
+
+        Parser xmlParser(xmlData);
+
+        std::cout << " --- Rendering : " << xmlParser.getName() << " ---" << std::endl;
+
+        scene.setBackgroundColor(xmlParser.getBackgroundColor());
+        scene.setMaxDepth(xmlParser.getMaxDepth());
+        scene.setLightSamples(xmlParser.getLightSamples());
+
+        for (auto object : xmlParser.getObjects()) scene.addObject(object);
+
+        for (auto source : xmlParser.getSources()) scene.addSource(source);
+
+        scene.setCamera(xmlParser.getCamera());
+        scene.buildAccelerationStructure();
+
+        return scene;
+    }
+}
+
+Scene testObj(const std::string &objFilename) {
+    Scene scene;
+
+    scene.addObject(MeshCache::load(objFilename));
+    scene.buildAccelerationStructure();
+    auto camera = std::make_shared<Camera>(glm::vec3(-7, 0, 0), glm::vec3(1, 0, 0), 0.1, 0.1, 1000,
+                                           1000, 0.1);
+    scene.setCamera(camera);
+
+    auto lightSource =
+        std::make_shared<DirectLight>(glm::vec3(-5, 0, 10), glm::vec3(1, 1, 1), 2000);
+    scene.addSource(lightSource);
+    scene.setMaxDepth(1);
+    return scene;
+}
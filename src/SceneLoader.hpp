@@ -0,0 +1,31 @@
+/**
+ * @file SceneLoader.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Build the scenes rendered by the executables
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <string>
+
+#include "Scene.hpp"
+
+/**
+ * @brief Load a scene described by an XML file and build its acceleration structure.
+ *
+ * @param filename the path of the XML file
+ * @return Scene
+ */
+Scene loadScene(const std::string &filename);
+
+/**
+ * @brief The scene of a mesh read from an OBJ file, seen from (-7, 0, 0) and lit by a single
+ * light.
+ *
+ * @param objFilename the path of the OBJ file
+ * @return Scene
+ */
+Scene testObj(const std::string &objFilename = "../data/sphere.obj");
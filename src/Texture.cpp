@@ -10,11 +10,16 @@
 
 #include "Texture.hpp"
 
-void Image::getPixelId(const glm::vec3 &intersectPt, int &hPix, int &wPix) const {
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void Image::getPixelId(const glm::vec3 &intersectPt, float &hAxis, float &wAxis, int &hPix,
+                       int &wPix) const {
     glm::vec3 pos = intersectPt - this->origin;
 
-    float hAxis = glm::dot(pos, hVec) / hVecNorm2;
-    float wAxis = glm::dot(pos, wVec) / wVecNorm2;
+    hAxis = glm::dot(pos, hVec) / hVecNorm2;
+    wAxis = glm::dot(pos, wVec) / wVecNorm2;
     hPix = hAxis * (float)height;
     wPix = wAxis * (float)width;
 }
@@ -23,22 +28,132 @@ bool Image::isInPicture(const int &hPix, const int &wPix) const {
     return hPix >= 0 && wPix >= 0 && hPix < (int)height && wPix < (int)width;
 }
 
-void Image::getPixel(const int &hPix, const int &wPix, std::vector<unsigned char> &color) const {
-    int id = (hPix * width + wPix) * 4;
-    color = std::vector<unsigned char>(this->pixels.begin() + id, this->pixels.begin() + id + 4);
+void MipMap::buildLevels(const unsigned &height, const unsigned &width) {
+    // Each level averages the squares of 2 x 2 pixels of the previous one, down to a single pixel.
+    // The last row or column of an odd level is dropped, and a single row or column is kept.
+    // The levels are first built row by row.
+    std::vector<Level> rows(1, Level{height, width, 0, 0});
+    auto texel = [&](const Level &level, unsigned h, unsigned w) {
+        return &pixels[level.offset + (h * level.width + w) * 4];
+    };
+    while (rows.back().height > 1 || rows.back().width > 1) {
+        const Level previous = rows.back();
+        const Level level{std::max(previous.height / 2, 1u), std::max(previous.width / 2, 1u), 0,
+                          pixels.size()};
+        pixels.resize(pixels.size() + 4 * level.height * level.width);
+        for (unsigned h = 0; h < level.height; ++h) {
+            const unsigned h0 = std::min(2 * h, previous.height - 1);
+            const unsigned h1 = std::min(2 * h + 1, previous.height - 1);
+            for (unsigned w = 0; w < level.width; ++w) {
+                const unsigned w0 = std::min(2 * w, previous.width - 1);
+                const unsigned w1 = std::min(2 * w + 1, previous.width - 1);
+                const unsigned char *p00 = texel(previous, h0, w0);
+                const unsigned char *p01 = texel(previous, h0, w1);
+                const unsigned char *p10 = texel(previous, h1, w0);
+                const unsigned char *p11 = texel(previous, h1, w1);
+                unsigned char *average = texel(level, h, w);
+                for (int channel = 0; channel < 4; ++channel) {
+                    average[channel] =
+                        (p00[channel] + p01[channel] + p10[channel] + p11[channel] + 2) / 4;
+                }
+            }
+        }
+        rows.push_back(level);
+    }
+
+    // Then each level is stored by blocks, the blocks on the right and bottom edges being padded
+    levels.clear();
+    size_t size = 0;
+    for (const Level &row : rows) {
+        const unsigned blocksPerRow = (row.width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const unsigned blocksPerColumn = (row.height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        levels.push_back(Level{row.height, row.width, blocksPerRow, size});
+        size += 4 * blocksPerRow * blocksPerColumn * BLOCK_SIZE * BLOCK_SIZE;
+    }
+    std::vector<unsigned char> blocks(size, 0);
+    for (unsigned id = 0; id < levels.size(); ++id) {
+        for (unsigned h = 0; h < levels[id].height; ++h) {
+            for (unsigned w = 0; w < levels[id].width; ++w) {
+                std::copy_n(texel(rows[id], h, w), 4, &blocks[texelIndex(levels[id], h, w)]);
+            }
+        }
+    }
+    this->pixels.swap(blocks);
+}
+
+MipMap::MipMap(const unsigned &height, const unsigned &width,
+               const std::vector<unsigned char> &pix)
+    : pixels(pix) {
+    buildLevels(height, width);
 }
 
-glm::vec4 Image::getColor(const glm::vec3 &pos, bool &onTexture) const {
+MipMap::MipMap(const std::string &filename) {
+    unsigned height = 0, width = 0;
+    ImgHandler ImgHandler;
+    this->pixels = ImgHandler.readPNG(filename, height, width);
+    // readPNG returns no pixel when the decoding fails
+    if (this->pixels.empty()) throw std::runtime_error("Cannot read the texture " + filename);
+    buildLevels(height, width);
+}
+
+std::vector<unsigned char> MipMap::getPixels() const {
+    std::vector<unsigned char> image(4 * getHeight() * getWidth());
+    for (unsigned h = 0; h < getHeight(); ++h) {
+        for (unsigned w = 0; w < getWidth(); ++w) {
+            std::copy_n(&pixels[texelIndex(levels[0], h, w)], 4, &image[(h * getWidth() + w) * 4]);
+        }
+    }
+    return image;
+}
+
+glm::vec4 MipMap::getBilinearColor(const unsigned &level, const float &hAxis,
+                                   const float &wAxis) const {
+    const Level &mip = levels[level];
+    // The centers of the pixels are at the half integers
+    const float h = hAxis * (float)mip.height - 0.5f;
+    const float w = wAxis * (float)mip.width - 0.5f;
+    const float hFloor = std::floor(h);
+    const float wFloor = std::floor(w);
+    const float hWeight = h - hFloor;
+    const float wWeight = w - wFloor;
+
+    auto clampH = [&](int h) { return std::min(std::max(h, 0), (int)mip.height - 1); };
+    auto clampW = [&](int w) { return std::min(std::max(w, 0), (int)mip.width - 1); };
+    const int h0 = clampH(hFloor);
+    const int w0 = clampW(wFloor);
+    const int h1 = clampH(hFloor + 1);
+    const int w1 = clampW(wFloor + 1);
+
+    const glm::vec4 top =
+        getPixel(level, h0, w0) * (1 - wWeight) + getPixel(level, h0, w1) * wWeight;
+    const glm::vec4 bottom =
+        getPixel(level, h1, w0) * (1 - wWeight) + getPixel(level, h1, w1) * wWeight;
+    return top * (1 - hWeight) + bottom * hWeight;
+}
+
+glm::vec4 Image::getColor(const glm::vec3 &pos, const float &footprint, bool &onTexture) const {
+    float hAxis, wAxis;
     int hPix, wPix;
-    std::vector<unsigned char> color(4);
+    getPixelId(pos, hAxis, wAxis, hPix, wPix);
+
+    if (!isInPicture(hPix, wPix)) return glm::vec4(0, 0, 0, 1);
+    onTexture = true;
 
-    getPixelId(pos, hPix, wPix);
-    if (isInPicture(hPix, wPix)) {
-        onTexture = true;
-        getPixel(hPix, wPix, color);
+    // The level whose pixels are as wide as the footprint, the image itself when it is magnified
+    const float texels = footprint * texelDensity;
+    const float lod =
+        texels > 1.0f ? std::min(std::log2(texels), (float)(mipmap->getLevelCount() - 1)) : 0;
+
+    if (filtering == BILINEAR) {
+        const unsigned level = lod;
+        const float weight = lod - level;
+        const glm::vec4 color = mipmap->getBilinearColor(level, hAxis, wAxis);
+        if (weight == 0) return color;
+        return color * (1 - weight) + mipmap->getBilinearColor(level + 1, hAxis, wAxis) * weight;
     }
-    return glm::vec4(color[0] / 255.0f, color[1] / 255.0f, color[2] / 255.0f,
-                     1.0f - color[3] / 255.0f);
+    const unsigned level = lod + 0.5f;
+    if (level == 0) return mipmap->getPixel(0, hPix, wPix);
+    return mipmap->getNearestColor(level, hAxis, wAxis);
 }
 
 std::ostream &Image::printInfo(std::ostream &os) const {
@@ -50,10 +165,11 @@ std::ostream &Image::printInfo(std::ostream &os) const {
               << "wVec: " << wVec << std::endl;
 }
 
-glm::vec4 CheckedPattern2D::getColor(const glm::vec3 &pos, bool &onTexture) const {
+glm::vec4 CheckedPattern2D::getColor(const glm::vec3 &pos, const float & /*footprint*/,
+                                     bool &onTexture) const {
     onTexture = (std::sin(std::abs(pos[0]+1)) > 0 && std::sin(std::abs(pos[1])+1) > 0);
     return glm::vec4(color[0], color[1], color[2], 0);
-};
+}
 
 std::ostream &CheckedPattern2D::printInfo(std::ostream &os) const {
     return os << "  --  CheckedPattern3D  --" << std::endl << "color: " << color << std::endl;
@@ -11,6 +11,10 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <glm/geometric.hpp>
@@ -32,10 +36,12 @@ public:
      * @brief Get the Color of the texture at certain coordinates
      *
      * @param pos the coordinates of the intersection point.
-     * @
+     * @param footprint the width of the area of the texture seen through the pixel, 0 for a point
+     * @param onTexture true if the texture is defined at these coordinates
      * @return glm::vec4
      */
-    virtual glm::vec4 getColor(const glm::vec3 &pos, bool &onTexture) const = 0;
+    virtual glm::vec4 getColor(const glm::vec3 &pos, const float &footprint,
+                               bool &onTexture) const = 0;
 
     /**
      * @brief
@@ -58,12 +64,180 @@ protected:
     virtual std::ostream &printInfo(std::ostream &os) const = 0;
 };
 
+/**
+ * @class MipMap
+ * @brief The pixels of an image and of its mipmap, which may be shared by several textures
+ *
+ * The pixels are stored by blocks of BLOCK_SIZE x BLOCK_SIZE pixels, each block being contiguous:
+ * the neighbours of a pixel are in the same few cache lines whatever the direction in which the
+ * image is walked, for instance along its columns when it is seen at a grazing angle.
+ */
+class MipMap {
+public:
+    /**
+     * @brief The number of pixels of the side of a block, a power of 2.
+     *
+     */
+    static constexpr unsigned BLOCK_SIZE = 8;
+
+    /**
+     * @brief A level of the mipmap, stored after the previous level in the pixels.
+     *
+     */
+    struct Level {
+        unsigned height;
+        unsigned width;
+        /**
+         * @brief The number of blocks along the width, the last one being partly filled.
+         *
+         */
+        unsigned blocksPerRow;
+        size_t offset;
+    };
+
+protected:
+    /**
+     * @brief The pixels of the image, followed by the pixels of the smaller levels of its mipmap,
+     * by blocks.
+     *
+     */
+    std::vector<unsigned char> pixels;
+
+    /**
+     * @brief The levels of the mipmap, from the image itself to a single pixel, each level being
+     * half of the previous one.
+     *
+     */
+    std::vector<Level> levels;
+
+    /**
+     * @brief Build the levels of the mipmap after the pixels of the image, then store them by
+     * blocks
+     *
+     * @param height the height of the image in pixels
+     * @param width the width of the image in pixels
+     */
+    void buildLevels(const unsigned &height, const unsigned &width);
+
+public:
+    /**
+     * @brief Get the height of the image in pixels
+     *
+     * @return unsigned
+     */
+    unsigned getHeight() const { return levels[0].height; }
+
+    /**
+     * @brief Get the width of the image in pixels
+     *
+     * @return unsigned
+     */
+    unsigned getWidth() const { return levels[0].width; }
+
+    /**
+     * @brief Get the number of levels of the mipmap
+     *
+     * @return unsigned
+     */
+    unsigned getLevelCount() const { return levels.size(); }
+
+    /**
+     * @brief Get the Pixels of the image itself, as RGBA
+     *
+     * @return std::vector<unsigned char>
+     */
+    std::vector<unsigned char> getPixels() const;
+
+    /**
+     * @brief The index of the first byte of a pixel of a level in the pixels
+     *
+     * @param level the level of the mipmap
+     * @param hPix id of the column
+     * @param wPix id of the row
+     * @return size_t
+     */
+    size_t texelIndex(const Level &level, const unsigned &hPix, const unsigned &wPix) const {
+        const size_t block = (hPix / BLOCK_SIZE) * level.blocksPerRow + wPix / BLOCK_SIZE;
+        return level.offset +
+               4 * (block * BLOCK_SIZE * BLOCK_SIZE + (hPix % BLOCK_SIZE) * BLOCK_SIZE +
+                    wPix % BLOCK_SIZE);
+    }
+
+    /**
+     * @brief Get the Pixel corresponding to a column (hPix) and a row (wPix) of a level of the
+     * mipmap, read directly from the packed pixels.
+     *
+     * @param level the level of the mipmap, 0 for the image itself
+     * @param hPix id of the column
+     * @param wPix id of the row
+     * @return glm::vec4 - R G B and transparency in [0,1]
+     */
+    glm::vec4 getPixel(const unsigned &level, const int &hPix, const int &wPix) const {
+        const unsigned char *texel = &this->pixels[texelIndex(levels[level], hPix, wPix)];
+        return glm::vec4(texel[0] / 255.0f, texel[1] / 255.0f, texel[2] / 255.0f,
+                         1.0f - texel[3] / 255.0f);
+    }
+
+    /**
+     * @brief Get the Pixel of a level of the mipmap containing a point of the image
+     *
+     * @param level the level of the mipmap
+     * @param hAxis the vertical coordinate of the point, in [0, 1[ in the image
+     * @param wAxis the horizontal coordinate of the point, in [0, 1[ in the image
+     * @return glm::vec4 - R G B and transparency in [0,1]
+     */
+    glm::vec4 getNearestColor(const unsigned &level, const float &hAxis,
+                              const float &wAxis) const {
+        const Level &mip = levels[level];
+        return getPixel(level, std::min((int)(hAxis * mip.height), (int)mip.height - 1),
+                        std::min((int)(wAxis * mip.width), (int)mip.width - 1));
+    }
+
+    /**
+     * @brief Interpolate the 4 pixels around a point of a level of the mipmap, the pixels out of
+     * the level repeating its border.
+     *
+     * @param level the level of the mipmap
+     * @param hAxis the vertical coordinate of the point, in [0, 1[ in the image
+     * @param wAxis the horizontal coordinate of the point, in [0, 1[ in the image
+     * @return glm::vec4 - R G B and transparency in [0,1]
+     */
+    glm::vec4 getBilinearColor(const unsigned &level, const float &hAxis,
+                               const float &wAxis) const;
+
+    /**
+     * @brief Construct a new MipMap object from the pixels of an image
+     *
+     * @param height the height of the image in pixels
+     * @param width the width of the image in pixels
+     * @param pix the height * width pixels of the image, as RGBA
+     */
+    explicit MipMap(const unsigned &height, const unsigned &width,
+                    const std::vector<unsigned char> &pix);
+
+    /**
+     * @brief Construct a new MipMap object by decoding a PNG file
+     *
+     * @param filename the name of the file
+     */
+    explicit MipMap(const std::string &filename);
+};
+
 /**
  * @class Image
  * @brief A class representing an image
  *
  */
 class Image : public Texture {
+public:
+    /**
+     * @brief The reconstruction of the colors between the pixels of the image:
+     * - NEAREST: the color of the pixel containing the point
+     * - BILINEAR: the interpolation of the 4 pixels around the point
+     *
+     */
+    enum Filtering { NEAREST, BILINEAR };
+
 protected:
     /**
       @brief The origin of the image (top left)
@@ -107,10 +281,22 @@ protected:
     unsigned width;
 
     /**
-     * @brief The pixels of the image.
+     * @brief The number of pixels of the image per unit of length of the scene.
      *
      */
-    std::vector<unsigned char> pixels;
+    float texelDensity;
+
+    /**
+     * @brief The pixels of the image, shared by the textures of the same file.
+     *
+     */
+    std::shared_ptr<const MipMap> mipmap;
+
+    /**
+     * @brief The reconstruction of the colors between the pixels, NEAREST by default.
+     *
+     */
+    Filtering filtering;
 
 public:
     /**
@@ -132,23 +318,50 @@ public:
      *
      * @return std::vector<unsigned char>
      */
-    std::vector<unsigned char> getPixels() { return this->pixels; }
+    std::vector<unsigned char> getPixels() { return mipmap->getPixels(); }
+
+    /**
+     * @brief Set the Pixels of the image, and build its mipmap.
+     *
+     * @param pix the height * width pixels read from an image, as RGBA
+     */
+    void setPixels(const std::vector<unsigned char> &pix) {
+        this->mipmap = std::make_shared<const MipMap>(height, width, pix);
+    }
+
+    /**
+     * @brief Get the MipMap object
+     *
+     * @return std::shared_ptr<const MipMap>
+     */
+    std::shared_ptr<const MipMap> getMipMap() const { return this->mipmap; }
+
+    /**
+     * @brief Get the Filtering object
+     *
+     * @return Filtering
+     */
+    Filtering getFiltering() const { return this->filtering; }
 
     /**
-     * @brief Set the Pixels of the image.
+     * @brief Set the Filtering object
      *
-     * @param pix the pixels read from an image
+     * @param filter the reconstruction of the colors between the pixels
      */
-    void setPixels(const std::vector<unsigned char> &pix) { this->pixels = pix; }
+    void setFiltering(const Filtering &filter) { this->filtering = filter; }
 
     /**
-     * @brief Get the potential Pixel Ids (vertical and horizontal).
+     * @brief Get the position of a point on the image and the potential Pixel Ids (vertical and
+     * horizontal).
      *
      * @param intersectPt the coordinates of the intersect point
+     * @param hAxis the vertical position, in [0, 1[ on the image
+     * @param wAxis the horizontal position, in [0, 1[ on the image
      * @param hPix vertical pixel id modified to the right value
      * @param wPix horizontal pixel id modified to the right value
      */
-    void getPixelId(const glm::vec3 &intersectPt, int &hPix, int &wPix) const;
+    void getPixelId(const glm::vec3 &intersectPt, float &hAxis, float &wAxis, int &hPix,
+                    int &wPix) const;
 
     /**
      * @brief Function which returns if the pixel defined by hPix (vertical id) and wPix (horizonal
@@ -162,41 +375,41 @@ public:
     bool isInPicture(const int &hPix, const int &wPix) const;
 
     /**
-     * @brief Get the Pixel corresponding to a column (hPix) and a row (wPix).
-     *
-     * @param hPix id of the column
-     * @param wPix id of the row
-     * @param color glm::vec4: RGBA in [|0, 255|]
-     */
-    void getPixel(const int &hPix, const int &wPix, std::vector<unsigned char> &color) const;
-
-    /**
-     * @brief Get the Color of the image at some coordinates.
+     * @brief Get the Color of the image at some coordinates. The level of the mipmap is chosen so
+     * that its pixels are as wide as the footprint: with the NEAREST filtering the closest level
+     * is read, with the BILINEAR filtering the two closest levels are interpolated (trilinear
+     * filtering).
      *
      * @param pos the coordinates
+     * @param footprint the width of the area of the image seen through the pixel
      * @param onTexture true if the image is defined at these coordinates - False by DEFAULT
      * @return glm::vec4 - R G B and transparency in [0,1]
      */
-    glm::vec4 getColor(const glm::vec3 &pos, bool &onTexture) const override;
+    glm::vec4 getColor(const glm::vec3 &pos, const float &footprint,
+                       bool &onTexture) const override;
 
     /**
      * @brief Construct a new Image object. WVEC SHOULD BE NORMALIZED
      *
-     * @param filename the name of the file in std::string
+     * @param pixels the pixels of the image, which may be shared with other images
      * @param origin the coordinates of the origin of the image (top-left corner)
      * @param hVec the vertical vector of the image
      * @param wVec the horizontal vector of the image. Should be NORMALIZED for the ratios of the
      * image not to be modified
      */
-    explicit Image(const std::string &filename, const glm::vec3 &origin, const glm::vec3 &hVec,
-                   const glm::vec3 &wVec)
-        : origin(origin), hVec(hVec), hVecNorm2(glm::l2Norm(hVec) * glm::l2Norm(hVec)) {
-        ImgHandler ImgHandler;
-        this->setPixels(ImgHandler.readPNG(filename, this->height, this->width));
-
+    explicit Image(const std::shared_ptr<const MipMap> &pixels, const glm::vec3 &origin,
+                   const glm::vec3 &hVec, const glm::vec3 &wVec)
+        : origin(origin),
+          hVec(hVec),
+          hVecNorm2(glm::l2Norm(hVec) * glm::l2Norm(hVec)),
+          height(pixels->getHeight()),
+          width(pixels->getWidth()),
+          mipmap(pixels),
+          filtering(NEAREST) {
         this->wVec = wVec * glm::l2Norm(this->hVec) * (float)this->width / (float)this->height;
         this->wVecNorm2 = glm::l2Norm(this->wVec);
         this->wVecNorm2 *= wVecNorm2;
+        this->texelDensity = (float)this->height / glm::l2Norm(this->hVec);
 
         // If the image is not a square, change the origin
         if (this->width != this->height) {
@@ -211,6 +424,19 @@ public:
         }
     }
 
+    /**
+     * @brief Construct a new Image object. WVEC SHOULD BE NORMALIZED
+     *
+     * @param filename the name of the file in std::string
+     * @param origin the coordinates of the origin of the image (top-left corner)
+     * @param hVec the vertical vector of the image
+     * @param wVec the horizontal vector of the image. Should be NORMALIZED for the ratios of the
+     * image not to be modified
+     */
+    explicit Image(const std::string &filename, const glm::vec3 &origin, const glm::vec3 &hVec,
+                   const glm::vec3 &wVec)
+        : Image(std::make_shared<const MipMap>(filename), origin, hVec, wVec) {}
+
 protected:
     /**
      * @brief A normal member returning the information about the Image. It replaces the pure
@@ -239,9 +465,12 @@ public:
      * @brief Gets the Color of the tartan at some coordinates.
      *
      * @param pos the coordinates of the intersection point.
+     * @param footprint the width of the area seen through the pixel, unused
+     * @param onTexture true on the colored squares
      * @return glm::vec4
      */
-    glm::vec4 getColor(const glm::vec3 &pos, bool &onTexture) const override;
+    glm::vec4 getColor(const glm::vec3 &pos, const float &footprint,
+                       bool &onTexture) const override;
 
     /**
      * @brief Construct a new Checked Pattern 2D object with some color.
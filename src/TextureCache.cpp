@@ -0,0 +1,23 @@
+/**
+ * @file TextureCache.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The images of a scene, decoded once per file and shared by its textures
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "TextureCache.hpp"
+
+void TextureCache::prefetch(const std::string &filename) {
+    if (images.count(filename)) return;
+    images[filename] = std::async(std::launch::async, [filename]() {
+                           return std::shared_ptr<const MipMap>(
+                               std::make_shared<const MipMap>(filename));
+                       }).share();
+}
+
+std::shared_ptr<const MipMap> TextureCache::get(const std::string &filename) {
+    prefetch(filename);
+    return images[filename].get();
+}
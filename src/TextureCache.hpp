@@ -0,0 +1,57 @@
+/**
+ * @file TextureCache.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The images of a scene, decoded once per file and shared by its textures
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Texture.hpp"
+
+/**
+ * @brief A registry of the images, keyed by the name of their file. Each file is decoded once, in
+ * a thread of its own, and its pixels are shared by all the textures using it.
+ *
+ * The decoding starts as soon as a file is prefetched, so that the rest of the scene is read in the
+ * meantime: only getting the pixels waits for the end of the decoding.
+ * @class TextureCache
+ */
+class TextureCache {
+protected:
+    /**
+     * @brief The pixels of each file, being decoded or ready.
+     *
+     */
+    std::map<std::string, std::shared_future<std::shared_ptr<const MipMap>>> images;
+
+public:
+    /**
+     * @brief Start decoding a file in the background, if it is not in the cache yet
+     *
+     * @param filename the name of the PNG file
+     */
+    void prefetch(const std::string &filename);
+
+    /**
+     * @brief Get the pixels of a file, decoding it if it was not prefetched
+     *
+     * @param filename the name of the PNG file
+     * @return std::shared_ptr<const MipMap> the pixels shared by all the textures of the file
+     */
+    std::shared_ptr<const MipMap> get(const std::string &filename);
+
+    /**
+     * @brief Get the number of files in the cache
+     *
+     * @return size_t
+     */
+    size_t size() const { return images.size(); }
+};
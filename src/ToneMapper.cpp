@@ -0,0 +1,146 @@
+/**
+ * @file ToneMapper.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The tone curves follow "Photographic Tone Reproduction for Digital Images" (Reinhard et
+ * al.) and the ACES fit of Krzysztof Narkowicz
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#include "ToneMapper.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief The base 2 logarithm of a positive float, with an absolute error below 2e-5. Unlike
+ * std::log2, it is vectorized.
+ *
+ */
+inline float fastLog2(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const float exponent = (float)((int)(bits >> 23) - 127);
+    bits = (bits & 0x7FFFFF) | 0x3F800000;
+    float m;  // in [1, 2[
+    std::memcpy(&m, &bits, sizeof(m));
+    // Least squares polynomial of log2 on [1, 2]
+    return exponent +
+           (((((0.043928432f * m - 0.40947411f) * m + 1.6101732f) * m - 3.5202124f) * m +
+             5.0697517f) *
+                m -
+            2.7941524f);
+}
+
+/**
+ * @brief 2 to the power of a float, with a relative error below 4e-6. Unlike std::exp2, it is
+ * vectorized. The results below 2^-126 are flushed to 0, and those above 2^127 to infinity.
+ *
+ */
+inline float fastExp2(float value) {
+    // The exponent is clamped as an integer, since a clamp of the float before its conversion
+    // would keep the loops from being vectorized
+    const float shifted = value + 127.0f;
+    int32_t biased = (int32_t)shifted;
+    const float f = shifted - (float)biased;  // in [0, 1[ for the results in range
+    // Least squares polynomial of 2^f on [0, 1]
+    const float mantissa =
+        (((0.013683983f * f + 0.051717735f) * f + 0.24162132f) * f + 0.69296955f) * f + 1.0000036f;
+    biased = biased < 1 ? 0 : (biased > 254 ? 255 : biased);
+    const int32_t bits = biased << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return mantissa * scale;
+}
+
+/**
+ * @brief Map the colors of a row with a given curve, the loop over the pixels being vectorized.
+ * The colors stay in the scale of the framebuffer, 255 being the white, so that the clamped colors
+ * are exactly the truncated ones.
+ *
+ */
+template <bool APPLY_GAMMA, typename CurveFunction>
+void mapPixels(const glm::vec4 *pixels, unsigned resY, uint32_t *rgba, float exposure,
+               float inverseGamma, CurveFunction applyCurve) {
+    auto mapChannel = [&](float value) {
+        value = applyCurve(value);
+        value = value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value);
+        if constexpr (APPLY_GAMMA) {
+            value = 255.0f * fastExp2(inverseGamma * fastLog2(value / 255.0f));
+            // The approximations may go slightly past the white
+            value = value > 255.0f ? 255.0f : value;
+        }
+        return (uint32_t)value;
+    };
+
+#pragma omp simd
+    for (unsigned y = 0; y < resY; ++y) {
+        // The sums of the pixels without sample are 0. The ternaries, unlike std::max, keep the
+        // values in registers, so that the loop is vectorized
+        const float count = pixels[y].w;
+        const float scale = exposure / (count > 1.0f ? count : 1.0f);
+        rgba[y] = mapChannel(pixels[y].x * scale) | mapChannel(pixels[y].y * scale) << 8 |
+                  mapChannel(pixels[y].z * scale) << 16 | 0xFF000000u;
+    }
+}
+
+template <typename CurveFunction>
+void mapRowWith(const Framebuffer &framebuffer, unsigned x, uint32_t *rgba, float exposure,
+                float gamma, CurveFunction applyCurve) {
+    const glm::vec4 *pixels = framebuffer.getRowSamples(x);
+    if (gamma == 1.0f) {
+        mapPixels<false>(pixels, framebuffer.getResY(), rgba, exposure, 1.0f, applyCurve);
+    } else {
+        mapPixels<true>(pixels, framebuffer.getResY(), rgba, exposure, 1.0f / gamma, applyCurve);
+    }
+}
+
+}  // namespace
+
+void ToneMapper::adaptExposure(const Framebuffer &framebuffer) {
+    if (!autoExposure) return;
+
+    const int resX = framebuffer.getResX();
+    const unsigned resY = framebuffer.getResY();
+    double logSum = 0;
+#pragma omp parallel for reduction(+ : logSum)
+    for (int x = 0; x < resX; ++x) {
+        const glm::vec4 *pixels = framebuffer.getRowSamples(x);
+        float rowSum = 0;
+#pragma omp simd reduction(+ : rowSum)
+        for (unsigned y = 0; y < resY; ++y) {
+            const float count = pixels[y].w;
+            const float scale = 1.0f / (255.0f * (count > 1.0f ? count : 1.0f));
+            const float luminance =
+                scale * (0.2126f * pixels[y].x + 0.7152f * pixels[y].y + 0.0722f * pixels[y].z);
+            // The offset keeps the black pixels from sending the average to 0
+            rowSum += fastLog2(1e-4f + (luminance > 0.0f ? luminance : 0.0f));
+        }
+        logSum += rowSum;
+    }
+
+    const double logAverage = std::exp2(logSum / ((double)resX * resY));
+    exposure = key / logAverage;
+}
+
+void ToneMapper::mapRow(const Framebuffer &framebuffer, unsigned x, uint32_t *rgba) const {
+    switch (curve) {
+        case CLAMP:
+            mapRowWith(framebuffer, x, rgba, exposure, gamma, [](float value) { return value; });
+            break;
+        case REINHARD:
+            mapRowWith(framebuffer, x, rgba, exposure, gamma,
+                       [](float value) { return 255.0f * value / (255.0f + value); });
+            break;
+        case ACES:
+            mapRowWith(framebuffer, x, rgba, exposure, gamma, [](float value) {
+                const float c = value / 255.0f;
+                return 255.0f * (c * (2.51f * c + 0.03f)) / (c * (2.43f * c + 0.59f) + 0.14f);
+            });
+            break;
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * @file ToneMapper.hpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief The adaptation of the luminosity of the rendered images to the 8 bits of the PNG files
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "Framebuffer.hpp"
+
+/**
+ * @brief Converts the linear colors of a framebuffer (255 being the white) to 8 bits colors:
+ * exposure, tone curve, then gamma. The exposure may be adapted to the image, so that its
+ * log-average luminance becomes the middle gray given by the key.
+ *
+ * The default tone mapper only clamps the colors to the white, the images being otherwise
+ * unchanged.
+ * @class ToneMapper
+ */
+class ToneMapper {
+public:
+    /**
+     * @brief The curve compressing the colors brighter than the white:
+     * - CLAMP: the colors are cut to the white
+     * - REINHARD: c / (1 + c)
+     * - ACES: the fit of the ACES filmic curve by Krzysztof Narkowicz
+     *
+     */
+    enum Curve { CLAMP, REINHARD, ACES };
+
+protected:
+    Curve curve;
+
+    /**
+     * @brief The factor of the colors, before the curve.
+     *
+     */
+    float exposure;
+
+    /**
+     * @brief True if the exposure is computed from the luminance of each image.
+     *
+     */
+    bool autoExposure;
+
+    /**
+     * @brief The luminance (1 being the white) the log-average luminance is brought to by the
+     * automatic exposure.
+     *
+     */
+    float key;
+
+    float gamma;
+
+public:
+    /**
+     * @brief Get the Curve object
+     *
+     * @return Curve
+     */
+    Curve getCurve() const { return this->curve; }
+
+    /**
+     * @brief Set the Curve object
+     *
+     * @param c the tone curve
+     */
+    void setCurve(const Curve &c) { this->curve = c; }
+
+    /**
+     * @brief Get the Exposure object
+     *
+     * @return float the factor of the colors, the last one computed with the automatic exposure
+     */
+    float getExposure() const { return this->exposure; }
+
+    /**
+     * @brief Set the Exposure object, and disable the automatic exposure
+     *
+     * @param e the factor of the colors
+     */
+    void setExposure(const float &e) {
+        this->exposure = e;
+        this->autoExposure = false;
+    }
+
+    /**
+     * @brief Get the Auto Exposure object
+     *
+     * @return true if the exposure is adapted to each image
+     */
+    bool getAutoExposure() const { return this->autoExposure; }
+
+    /**
+     * @brief Set the Auto Exposure object
+     *
+     * @param automatic true to adapt the exposure to each image
+     * @param k the luminance of the middle gray, 0.18 for a usual scene
+     */
+    void setAutoExposure(const bool &automatic, const float &k = 0.18f) {
+        this->autoExposure = automatic;
+        this->key = k;
+    }
+
+    /**
+     * @brief Get the Gamma object
+     *
+     * @return float
+     */
+    float getGamma() const { return this->gamma; }
+
+    /**
+     * @brief Set the Gamma object
+     *
+     * @param g the gamma of the display, 2.2 for the usual screens and 1 to keep the colors linear
+     */
+    void setGamma(const float &g) { this->gamma = g; }
+
+    /**
+     * @brief Tells whether the whole image must be rendered before its first row is mapped
+     *
+     * @return true with the automatic exposure
+     */
+    bool needsWholeImage() const { return this->autoExposure; }
+
+    /**
+     * @brief With the automatic exposure, compute the exposure of an image from its log-average
+     * luminance. The pixels are reduced in parallel.
+     *
+     * @param framebuffer the whole image
+     */
+    void adaptExposure(const Framebuffer &framebuffer);
+
+    /**
+     * @brief Map a row to 8 bits RGBA colors. Each pixel is written at once as a 32 bits word, R
+     * being its lowest byte, so that the loop is vectorized: on little endian processors the
+     * bytes of the row are R, G, B, A for each pixel.
+     *
+     * @param framebuffer the image
+     * @param x the row
+     * @param rgba the resY pixels of the row
+     */
+    void mapRow(const Framebuffer &framebuffer, unsigned x, uint32_t *rgba) const;
+
+    /**
+     * @brief Construct a new Tone Mapper object, which clamps the colors
+     *
+     */
+    explicit ToneMapper()
+        : curve(CLAMP), exposure(1.0f), autoExposure(false), key(0.18f), gamma(1.0f) {}
+
+    /**
+     * @brief Construct a new Tone Mapper object with the automatic exposure
+     *
+     * @param c the tone curve
+     * @param g the gamma of the display
+     */
+    explicit ToneMapper(const Curve &c, const float &g)
+        : curve(c), exposure(1.0f), autoExposure(true), key(0.18f), gamma(g) {}
+};
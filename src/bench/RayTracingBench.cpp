@@ -0,0 +1,175 @@
+/**
+ * @file RayTracingBench.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Renders the scenes of the data folder with fixed settings and reports the time and the
+ * number of rays of each render as JSON, to compare the performances of two versions.
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Framebuffer.hpp"
+#include "RayPacket.hpp"
+#include "RayTracer.hpp"
+#include "SceneLoader.hpp"
+
+/**
+ * @brief A render of the benchmark: a scene, rendered with sqrtAAPower^2 rays per pixel (1 for the
+ * standard ray tracer).
+ *
+ */
+struct BenchCase {
+    std::string scene;
+    int sqrtAAPower;
+};
+
+/**
+ * @brief The measures of a render.
+ *
+ */
+struct BenchRun {
+    BenchCase benchCase;
+    unsigned resX;
+    unsigned resY;
+    int threads;
+    double seconds;
+    RayCounters rays;
+    double speedup;
+};
+
+/**
+ * @brief The thread counts of the scaling measures: the powers of two below the number of threads
+ * available, and that number.
+ *
+ * @return std::vector<int>
+ */
+std::vector<int> threadCounts() {
+    int maxThreads = 1;
+#ifdef _OPENMP
+    maxThreads = omp_get_max_threads();
+#endif
+    std::vector<int> counts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) counts.push_back(threads);
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+/**
+ * @brief Render a scene with a given number of threads and measure the render.
+ *
+ * @param benchCase the scene and the anti-aliasing
+ * @param dataDir the folder of the scenes
+ * @param threads the number of threads
+ * @return BenchRun
+ */
+BenchRun runCase(const BenchCase &benchCase, const std::string &dataDir, int threads) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    // The OBJ file is rendered in the scene of testObj
+    bool isObj = benchCase.scene.size() > 4 &&
+                 benchCase.scene.compare(benchCase.scene.size() - 4, 4, ".obj") == 0;
+    Scene scene = isObj ? testObj(dataDir + "/" + benchCase.scene)
+                        : loadScene(dataDir + "/" + benchCase.scene);
+
+    std::unique_ptr<RayTracer> rayTracer;
+    if (benchCase.sqrtAAPower > 1) {
+        rayTracer = std::make_unique<FixedAntiAliasingRayTracer>(true, scene.getMaxDepth(),
+                                                                 benchCase.sqrtAAPower);
+    } else {
+        rayTracer = std::make_unique<StdRayTracer>(true, scene.getMaxDepth());
+    }
+
+    // Only the ray tracing is timed: the image stays in memory, without tone mapping nor encoding
+    Framebuffer framebuffer(scene.getCamera()->resX, scene.getCamera()->resY);
+    auto start = std::chrono::steady_clock::now();
+    rayTracer->renderFramebuffer(scene, framebuffer);
+    auto end = std::chrono::steady_clock::now();
+
+    BenchRun run;
+    run.benchCase = benchCase;
+    run.resX = scene.getCamera()->resX;
+    run.resY = scene.getCamera()->resY;
+    run.threads = threads;
+    run.seconds = std::chrono::duration<double>(end - start).count();
+    run.rays = rayTracer->getRayCounters();
+    run.speedup = 1;
+    return run;
+}
+
+/**
+ * @brief Write the measures as JSON.
+ *
+ * @param os the output stream
+ * @param runs the measures of the renders
+ */
+void writeJson(std::ostream &os, const std::vector<BenchRun> &runs) {
+    os << "{\n"
+       << "  \"packetWidth\": " << RayPacket::WIDTH << ",\n"
+       << "  \"runs\": [\n";
+    for (unsigned id = 0; id < runs.size(); ++id) {
+        const BenchRun &run = runs[id];
+        os << "    {\"scene\": \"" << run.benchCase.scene << "\", "
+           << "\"resX\": " << run.resX << ", "
+           << "\"resY\": " << run.resY << ", "
+           << "\"samplesPerPixel\": " << run.benchCase.sqrtAAPower * run.benchCase.sqrtAAPower
+           << ", "
+           << "\"threads\": " << run.threads << ", "
+           << "\"seconds\": " << run.seconds << ", "
+           << "\"primaryRays\": " << run.rays.primary << ", "
+           << "\"secondaryRays\": " << run.rays.secondary << ", "
+           << "\"shadowRays\": " << run.rays.shadow << ", "
+           << "\"raysPerSecond\": " << run.rays.total() / run.seconds << ", "
+           << "\"speedup\": " << run.speedup << ", "
+           << "\"efficiency\": " << run.speedup / run.threads << "}"
+           << (id + 1 < runs.size() ? ",\n" : "\n");
+    }
+    os << "  ]\n"
+       << "}\n";
+}
+
+int main(int argc, const char **argv) {
+    // ./RayTracingBench [dataDir] [output.json]
+    const std::string dataDir = argc >= 2 ? argv[1] : "../data";
+    const std::string output = argc >= 3 ? argv[2] : "RayTracingBench.json";
+
+    const std::vector<BenchCase> cases = {{"billiard.xml", 1},  {"billiard.xml", 2},
+                                          {"daltons.xml", 1},   {"walkTrees.xml", 1},
+                                          {"walkTrees.xml", 2}, {"prez.xml", 1},
+                                          {"sphere.obj", 1}};
+
+    std::vector<BenchRun> runs;
+    for (const BenchCase &benchCase : cases) {
+        double singleThreadSeconds = 0;
+        for (int threads : threadCounts()) {
+            BenchRun run = runCase(benchCase, dataDir, threads);
+            if (threads == 1) singleThreadSeconds = run.seconds;
+            run.speedup = singleThreadSeconds / run.seconds;
+            std::cout << benchCase.scene << " x" << run.benchCase.sqrtAAPower << ", " << threads
+                      << " thread(s): " << run.seconds << " s, "
+                      << run.rays.total() / run.seconds / 1e6 << " Mrays/s" << std::endl;
+            runs.push_back(run);
+        }
+    }
+
+    std::ofstream ofs(output);
+    if (!ofs.is_open()) {
+        std::cerr << "Cannot write " << output << std::endl;
+        return 1;
+    }
+    writeJson(ofs, runs);
+    std::cout << "Results written to " << output << std::endl;
+    return 0;
+}
@@ -9,63 +9,11 @@
  */
 
 #include <chrono>
-#include <fstream>
 #include <random>
 #include <string>
 
-#include "ObjParser.hpp"
-#include "Parser.hpp"
 #include "RayTracer.hpp"
-#include "Object/TriangleMesh.hpp"
-#include "Object/DirectLight.hpp"
-
-Scene loadScene(std::string filename) {
-    Scene scene;
-
-    std::ifstream ifs(filename);
-
-    if (!ifs.is_open()) {
-        throw std::runtime_error(
-            "The file representing your scene does not exist. Please check the path to your file ");
-    } else {
-        std::string xmlData((std::istreambuf_iterator<char>(ifs)),
-                            (std::istreambuf_iterator<char>()));
-
-        Parser xmlParser(xmlData);
-
-        std::cout << " --- Rendering : " << xmlParser.getName() << " ---" << std::endl;
-
-        scene.setBackgroundColor(xmlParser.getBackgroundColor());
-        scene.setMaxDepth(xmlParser.getMaxDepth());
-
-        for (auto object : xmlParser.getObjects()) scene.addObject(object);
-
-        for (auto source : xmlParser.getSources()) scene.addSource(source);
-
-        scene.setCamera(xmlParser.getCamera());
-
-        return scene;
-    }
-}
-
-Scene testObj() {
-    Scene scene;
-
-    ObjParser objParser;
-    PolygonMesh polyMesh = objParser.readObj("../data/sphere.obj");
-    TriangleMesh triMesh(polyMesh);
-
-    scene.addObject(std::make_shared<TriangleMesh>(triMesh));
-    auto camera = std::make_shared<Camera>(glm::vec3(-7, 0, 0), glm::vec3(1, 0, 0), 0.1, 0.1, 1000,
-                                           1000, 0.1);
-    scene.setCamera(camera);
-
-    auto lightSource =
-        std::make_shared<DirectLight>(glm::vec3(-5, 0, 10), glm::vec3(1, 1, 1), 2000);
-    scene.addSource(lightSource);
-    scene.setMaxDepth(1);
-    return scene;
-}
+#include "SceneLoader.hpp"
 
 int main(int argc, const char **argv) {
     std::cout << "Starting the ray-Tracing Software by Atoli Huppé and Olivier Laurent" << std::endl
@@ -120,7 +68,27 @@ int main(int argc, const char **argv) {
 
             srt.render(scene, "../data/sphere.png");
         }
-    } else if (argc == 2) {
+    }
+
+    // Optional last arguments: "pfm" or "exr" writes the linear colors in floats instead of a
+    // PNG, "reinhard" or "aces" tone maps the PNG with an automatic exposure
+    std::string extension = ".png";
+    ToneMapper toneMapper;
+    while (argc >= 3) {
+        const std::string option = argv[argc - 1];
+        if (option == "pfm" || option == "exr") {
+            extension = "." + option;
+        } else if (option == "reinhard") {
+            toneMapper = ToneMapper(ToneMapper::REINHARD, 2.2f);
+        } else if (option == "aces") {
+            toneMapper = ToneMapper(ToneMapper::ACES, 2.2f);
+        } else {
+            break;
+        }
+        --argc;
+    }
+
+    if (argc == 2) {
         std::cout << "Your file is going to be loaded. If you want, you may specify n - with "
                      "(n<5) - if you want some anti-anliasing."
                   << std::endl;
@@ -132,8 +100,9 @@ int main(int argc, const char **argv) {
         Scene scene = loadScene("../data/" + filename);
 
         StdRayTracer srt(true, scene.getMaxDepth());
+        srt.setToneMapper(toneMapper);
 
-        srt.render(scene, "../data/" + rawname + ".png");
+        srt.render(scene, "../data/" + rawname + extension);
     } else if (argc >= 3) {
         std::cout << "Your file is going to be loaded." << std::endl;
         
@@ -143,9 +112,25 @@ int main(int argc, const char **argv) {
 
         Scene scene = loadScene("../data/" + filename);
 
-        FixedAntiAliasingRayTracer AArt(true, scene.getMaxDepth(), std::stoi(argv[2]));
+        if (std::string(argv[2]) == "fxaa") {
+            FxaaRayTracer fxaart(true, scene.getMaxDepth());
+            fxaart.setToneMapper(toneMapper);
+
+            fxaart.render(scene, "../data/" + rawname + extension);
+        } else if (std::string(argv[2]) == "adaptive") {
+            unsigned maxSamples = argc >= 4 ? std::stoi(argv[3]) : 64;
+            StochasticAntiAliasingRayTracer AArt(true, scene.getMaxDepth(), maxSamples);
+            AArt.setToneMapper(toneMapper);
 
-        AArt.render(scene, "../data/" + rawname + ".png");
+            AArt.render(scene, "../data/" + rawname + extension);
+            std::cout << "Adaptive anti-aliasing: " << AArt.getRayCounters().primary
+                      << " primary rays" << std::endl;
+        } else {
+            FixedAntiAliasingRayTracer AArt(true, scene.getMaxDepth(), std::stoi(argv[2]));
+            AArt.setToneMapper(toneMapper);
+
+            AArt.render(scene, "../data/" + rawname + extension);
+        }
     }
     return 0;
 }
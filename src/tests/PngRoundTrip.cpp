@@ -0,0 +1,166 @@
+/**
+ * @file PngRoundTrip.cpp
+ * @author Atoli Huppé & Olivier Laurent
+ * @brief Encodes images with PngStreamWriter and decodes them with lodepng, to check that the
+ * encoder writes exactly the given pixels.
+ * @version 1.0
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "PngStreamWriter.hpp"
+#include "lodepng/lodepng.h"
+
+/**
+ * @brief An image of the check: its size and the RGBA bytes of its pixels, row by row.
+ *
+ */
+struct RoundTripCase {
+    std::string name;
+    unsigned width;
+    unsigned height;
+    std::vector<unsigned char> rgba;
+};
+
+/**
+ * @brief Build an image whose pixels are given by a function of their position.
+ *
+ * @param name the name of the case, printed with the result
+ * @param width the number of pixels of a row
+ * @param height the number of rows
+ * @param pixel fills the 4 bytes of the pixel (row, column)
+ * @return RoundTripCase
+ */
+RoundTripCase makeCase(const std::string &name, unsigned width, unsigned height,
+                       const std::function<void(unsigned, unsigned, unsigned char *)> &pixel) {
+    RoundTripCase roundTripCase{name, width, height,
+                                std::vector<unsigned char>(4 * width * height)};
+    for (unsigned row = 0; row < height; ++row) {
+        for (unsigned col = 0; col < width; ++col) {
+            pixel(row, col, &roundTripCase.rgba[4 * (row * width + col)]);
+        }
+    }
+    return roundTripCase;
+}
+
+/**
+ * @brief Deterministic pseudo-random bytes (xorshift), the same on every run.
+ *
+ * @param state the state of the generator, updated
+ * @return unsigned char
+ */
+unsigned char randomByte(uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state >> 24;
+}
+
+/**
+ * @brief Encode an image, decode the file and compare the pixels.
+ *
+ * @param roundTripCase the image
+ * @param filename the temporary PNG file
+ * @return true if the decoded image is the same
+ */
+bool roundTrip(const RoundTripCase &roundTripCase, const std::string &filename) {
+    {
+        PngStreamWriter writer(filename, roundTripCase.width, roundTripCase.height);
+        for (unsigned row = 0; row < roundTripCase.height; ++row) {
+            writer.writeRow(&roundTripCase.rgba[4 * row * roundTripCase.width]);
+        }
+        writer.close();
+    }
+
+    unsigned char *decoded = nullptr;
+    unsigned width = 0, height = 0;
+    unsigned error = lodepng_decode32_file(&decoded, &width, &height, filename.c_str());
+    std::remove(filename.c_str());
+    if (error) {
+        std::cerr << roundTripCase.name << ": FAILED, lodepng error " << error << " ("
+                  << lodepng_error_text(error) << ")" << std::endl;
+        return false;
+    }
+    bool same = width == roundTripCase.width && height == roundTripCase.height;
+    if (!same) {
+        std::cerr << roundTripCase.name << ": FAILED, decoded as " << width << "x" << height
+                  << std::endl;
+    }
+    for (size_t byte = 0; same && byte < roundTripCase.rgba.size(); ++byte) {
+        if (decoded[byte] != roundTripCase.rgba[byte]) {
+            const size_t pixel = byte / 4;
+            std::cerr << roundTripCase.name << ": FAILED, pixel (" << pixel / width << ", "
+                      << pixel % width << ") channel " << byte % 4 << " is "
+                      << (int)decoded[byte] << " instead of " << (int)roundTripCase.rgba[byte]
+                      << std::endl;
+            same = false;
+        }
+    }
+    std::free(decoded);
+    if (same) {
+        std::cout << roundTripCase.name << " (" << roundTripCase.width << "x"
+                  << roundTripCase.height << "): ok" << std::endl;
+    }
+    return same;
+}
+
+int main(int argc, const char **argv) {
+    // ./PngRoundTrip [temporary.png]
+    const std::string filename = argc >= 2 ? argv[1] : "PngRoundTrip.png";
+
+    uint32_t state = 2463534242u;
+    const std::vector<RoundTripCase> cases = {
+        makeCase("single pixel", 1, 1,
+                 [](unsigned, unsigned, unsigned char *p) {
+                     p[0] = 200, p[1] = 100, p[2] = 50, p[3] = 255;
+                 }),
+        makeCase("flat", 640, 480,
+                 [](unsigned, unsigned, unsigned char *p) {
+                     p[0] = 30, p[1] = 60, p[2] = 90, p[3] = 255;
+                 }),
+        makeCase("odd width gradient", 333, 77,
+                 [](unsigned row, unsigned col, unsigned char *p) {
+                     p[0] = row * 3, p[1] = col, p[2] = row + col, p[3] = 255 - col % 7;
+                 }),
+        makeCase("single column", 1, 257,
+                 [](unsigned row, unsigned, unsigned char *p) {
+                     p[0] = row, p[1] = 255 - row, p[2] = row * row, p[3] = 255;
+                 }),
+        makeCase("single row", 1001, 1,
+                 [](unsigned, unsigned col, unsigned char *p) {
+                     p[0] = col, p[1] = col >> 2, p[2] = col * 7, p[3] = 255;
+                 }),
+        // Repeated tiles, for the matches at all distances of the window
+        makeCase("tiles", 517, 311,
+                 [](unsigned row, unsigned col, unsigned char *p) {
+                     const unsigned tile = (row / 13 + col / 29) % 5;
+                     p[0] = tile * 50, p[1] = (row % 13) * 19, p[2] = (col % 29) * 8, p[3] = 255;
+                 }),
+        // Random bytes, which are literals: many blocks of more than 16k symbols
+        makeCase("noise", 513, 511,
+                 [&state](unsigned, unsigned, unsigned char *p) {
+                     for (int channel = 0; channel < 4; ++channel) p[channel] = randomByte(state);
+                 }),
+    };
+
+    unsigned failures = 0;
+    for (const RoundTripCase &roundTripCase : cases) {
+        if (!roundTrip(roundTripCase, filename)) ++failures;
+    }
+    if (failures) {
+        std::cerr << failures << " of " << cases.size() << " images differ after the round trip"
+                  << std::endl;
+        return 1;
+    }
+    std::cout << "All the images are decoded as encoded" << std::endl;
+    return 0;
+}
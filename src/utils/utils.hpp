@@ -9,6 +9,9 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <iostream>
+
 #include <glm/vec3.hpp>
 
 #define KEPSILON 0.00001
@@ -43,4 +46,28 @@ inline glm::vec3 mult(const glm::vec3 &lhs, const glm::vec3 &rhs) {
     return glm::vec3(lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z);
 }
 
+/**
+ * @brief Integer hash mixing all the bits of its input (from the finalizer of MurmurHash3). Used
+ * to draw deterministic random numbers, which do not depend on the order of the threads.
+ *
+ * @param x the value to hash
+ * @return uint32_t
+ */
+inline uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Map a hashed value to a float in [0, 1[
+ *
+ * @param h the hashed value
+ * @return float
+ */
+inline float toUnitFloat(uint32_t h) { return (h >> 8) * (1.0f / 16777216.0f); }
+
 }  // namespace detail